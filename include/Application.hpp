@@ -7,12 +7,23 @@
 #include "BuildingManager.hpp"
 #include "KeyManager.hpp"
 #include "MaterialManager.hpp"
+#include "Minimap.hpp"
+#include "TextureAtlas.hpp"
+#include "TileAutomaton.hpp"
 #include "Tilemap.hpp"
 #include "UpgradeManager.hpp"
 
 /**
  * @brief Base application class.
  *
+ * @remarks Frames are only rendered when something changed: input, window
+ * events, or ticks. The simulation keeps running while idle, and the loop
+ * sleeps until the next tick, growth step or frame is due, waking early for
+ * input while focused. Unfocused windows redraw at most once a second.
+ *
+ * @remarks The map is drawn through mMapView, zoomed with the mouse wheel.
+ * Past LOD_ZOOM, the minimap is drawn in place of the tiles & buildings.
+ *
  */
 class Application
 {
@@ -35,6 +46,25 @@ private:
 	const sf::Color BG_COLOR = sf::Color(100, 100, 255);
 
 	const sf::Vector2i WINDOW_SIZE = {900, 680};
+
+	/// How often input is checked for while idle & focused.
+	const sf::Time INPUT_POLL_TIME = sf::milliseconds(2);
+
+	/// The shortest time between frames while unfocused.
+	const sf::Time UNFOCUSED_FRAME_TIME = sf::seconds(1.0f);
+
+	/// How many frames to render after a change, so ImGui can settle.
+	const unsigned REDRAW_FRAMES = 2;
+
+	/// The size of the GUI panels to the right & bottom of the map.
+	const sf::Vector2i GUI_SIZE = {260, 200};
+
+	/// The zoom range, as map pixels per screen pixel.
+	const float MIN_ZOOM = 0.5f;
+	const float MAX_ZOOM = 16.0f;
+
+	/// The zoom past which the minimap is drawn instead of the tiles.
+	const float LOD_ZOOM = 4.0f;
 	///////////////////////////////////////////////
 
 	/**
@@ -49,6 +79,55 @@ private:
 	 */
 	sf::Clock mImGuiClock;
 
+	/**
+	 * @brief How many more frames need rendering.
+	 *
+	 */
+	unsigned mRedrawFrames;
+
+	/**
+	 * @brief True if the window has focus.
+	 *
+	 */
+	bool mFocused;
+
+	/**
+	 * @brief Time since the last frame rendered while unfocused.
+	 *
+	 */
+	sf::Clock mUnfocusedClock;
+
+	/**
+	 * @brief Request a redraw of the next few frames.
+	 *
+	 */
+	void requestRedraw();
+
+	/**
+	 * @brief Returns true if a frame should be rendered now.
+	 *
+	 */
+	bool shouldRedraw() const;
+
+	/**
+	 * @brief Handle a window event, & request a redraw.
+	 *
+	 */
+	void handleEvent(const sf::Event &event);
+
+	/**
+	 * @brief Sleep until the next update is due, or while focused, until
+	 * input arrives.
+	 *
+	 */
+	void idle();
+
+	/**
+	 * @brief Every building, icon, upgrade & tile image, in one texture.
+	 *
+	 */
+	TextureAtlas mAtlas;
+
 	/**
 	 * @brief The main map.
 	 *
@@ -67,6 +146,44 @@ private:
 	 */
 	UpgradeManager mUpgrades;
 
+	/**
+	 * @brief One pixel per tile overview of the map & buildings.
+	 *
+	 */
+	Minimap mMinimap;
+
+	/**
+	 * @brief Regrows the map's tiles, at its own tick rate.
+	 *
+	 */
+	TileAutomaton mGrowth;
+
+	/**
+	 * @brief The view the map is drawn through.
+	 *
+	 */
+	sf::View mMapView;
+
+	/**
+	 * @brief The current zoom, as map pixels per screen pixel.
+	 *
+	 */
+	float mZoom;
+
+	/**
+	 * @brief Zoom the map view, clamped to the zoom range.
+	 *
+	 * @param factor The amount to multiply the zoom by.
+	 */
+	void zoomMap(float factor);
+
+	/**
+	 * @brief Renders the clickable minimap panel. Clicking centers the map
+	 * view on that point.
+	 *
+	 */
+	void renderGuiMinimap();
+
 	/**
 	 * @brief Begin & End the main ImGui windows.
 	 *
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief Fixed-size 128-bit signed integer used for all resource counts,
+ * prices & per-tick values.
+ *
+ * @remarks Arithmetic saturates at MAX / MIN instead of wrapping, so very
+ * long idle sessions cap out rather than going negative.
+ *
+ */
+class BigNumber
+{
+public:
+	/**
+	 * @brief The underlying storage type.
+	 *
+	 */
+	__extension__ typedef __int128 value_type;
+
+	/**
+	 * @brief Default constructor, initializes to 0.
+	 *
+	 */
+	BigNumber();
+
+	/**
+	 * @brief Construct from a plain integer.
+	 *
+	 * @param value The initial value.
+	 */
+	BigNumber(long long value);
+
+	/**
+	 * @brief Construct from a double, rounding to the nearest integer and
+	 * saturating if out of range.
+	 *
+	 * @param value The value to convert.
+	 * @return BigNumber The rounded value.
+	 */
+	static BigNumber fromDouble(double value);
+
+	/**
+	 * @brief Parse a base-10 integer string, with an optional leading '-'.
+	 *
+	 * @param str The string to parse.
+	 * @return BigNumber The parsed value.
+	 *
+	 * @throws std::invalid_argument If the string is not a valid integer.
+	 */
+	static BigNumber fromString(const std::string &str);
+
+	/**
+	 * @brief Construct directly from the underlying storage.
+	 *
+	 */
+	static BigNumber fromRaw(value_type raw);
+
+	/**
+	 * @brief The largest representable value.
+	 *
+	 */
+	static BigNumber max();
+
+	/**
+	 * @brief The smallest representable value.
+	 *
+	 */
+	static BigNumber min();
+
+	/**
+	 * @brief Retrieve the underlying storage.
+	 *
+	 */
+	value_type raw() const;
+
+	/**
+	 * @brief Convert to a double. Precision is lost beyond 2^53.
+	 *
+	 */
+	double toDouble() const;
+
+	/**
+	 * @brief Convert to a long long, saturating if out of range.
+	 *
+	 */
+	long long toLong() const;
+
+	/**
+	 * @brief True if the value fits into a long long.
+	 *
+	 */
+	bool fitsLong() const;
+
+	/**
+	 * @brief Returns every digit of the number, in base 10.
+	 *
+	 * @return std::string The exact representation.
+	 */
+	std::string toString() const;
+
+	/**
+	 * @brief Returns a short, human-readable representation for the GUI.
+	 *
+	 * @return std::string Ex: "999999", "1.50M", "12.34Qa"
+	 *
+	 * @remarks Values under a million are rendered exactly.
+	 */
+	std::string format() const;
+
+	BigNumber &operator+=(const BigNumber &rhs);
+	BigNumber &operator-=(const BigNumber &rhs);
+	BigNumber &operator*=(const BigNumber &rhs);
+	BigNumber &operator/=(const BigNumber &rhs);
+
+	friend BigNumber operator+(BigNumber lhs, const BigNumber &rhs);
+	friend BigNumber operator-(BigNumber lhs, const BigNumber &rhs);
+	friend BigNumber operator*(BigNumber lhs, const BigNumber &rhs);
+	friend BigNumber operator/(BigNumber lhs, const BigNumber &rhs);
+	friend BigNumber operator-(const BigNumber &v);
+
+	friend bool operator==(const BigNumber &lhs, const BigNumber &rhs);
+	friend bool operator!=(const BigNumber &lhs, const BigNumber &rhs);
+	friend bool operator<(const BigNumber &lhs, const BigNumber &rhs);
+	friend bool operator>(const BigNumber &lhs, const BigNumber &rhs);
+	friend bool operator<=(const BigNumber &lhs, const BigNumber &rhs);
+	friend bool operator>=(const BigNumber &lhs, const BigNumber &rhs);
+
+private:
+	/**
+	 * @brief The stored value.
+	 *
+	 */
+	value_type mValue;
+};
+
+/**
+ * @brief nlohmann::json serializer. Values that fit into a long long are
+ * stored as numbers, larger ones as strings of digits.
+ *
+ */
+void to_json(nlohmann::json &j, const BigNumber &n);
+
+/**
+ * @brief nlohmann::json deserializer. Accepts integers, floats and strings of
+ * digits.
+ *
+ */
+void from_json(const nlohmann::json &j, BigNumber &n);
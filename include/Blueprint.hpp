@@ -0,0 +1,101 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief A layout of buildings, as offsets from its top left tile.
+ *
+ * @remarks Cells hold building IDs. On disk, the building names are stored
+ * once each in a palette, & cells refer to them by index, so a blueprint
+ * survives buildings being reordered in object_data.json.
+ *
+ */
+class Blueprint
+{
+public:
+	/**
+	 * @brief A single building of the layout.
+	 *
+	 */
+	struct Cell
+	{
+		/// The tile offset from the blueprint's top left.
+		sf::Vector2i offset;
+		/// The building's ID.
+		unsigned building;
+	};
+
+	/**
+	 * @brief Default constructor, of an empty blueprint.
+	 *
+	 */
+	Blueprint();
+
+	/**
+	 * @brief Add a building to the layout.
+	 *
+	 * @param offset The tile offset from the top left, which must be
+	 * non-negative.
+	 * @param building The building's ID.
+	 */
+	void addCell(sf::Vector2i offset, unsigned building);
+
+	/**
+	 * @brief Get every building of the layout, in the order they were added.
+	 *
+	 */
+	const std::vector<Cell> &getCells() const;
+
+	/**
+	 * @brief Get the size of the layout's bounding box, in tiles.
+	 *
+	 */
+	sf::Vector2i getSize() const;
+
+	/**
+	 * @brief Check if the layout has no buildings.
+	 *
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Serialize the layout.
+	 *
+	 * @param names The name of every building, indexed by ID.
+	 */
+	nlohmann::json toJson(const std::vector<std::string> &names) const;
+
+	/**
+	 * @brief Deserialize a layout.
+	 *
+	 * @param data The output of toJson().
+	 * @param resolve Converts a building name to its ID, & throws if it
+	 * doesn't exist.
+	 *
+	 * @throws nlohmann::json::exception If the data is malformed.
+	 * @throws std::runtime_error If a cell has a negative offset.
+	 */
+	static Blueprint fromJson(const nlohmann::json &data,
+							  const std::function<unsigned(const std::string &)> &resolve);
+
+private:
+	/**
+	 * @brief Every building of the layout.
+	 *
+	 */
+	std::vector<Cell> mCells;
+
+	/**
+	 * @brief The size of the bounding box, in tiles.
+	 *
+	 */
+	sf::Vector2i mSize;
+};
@@ -9,10 +9,19 @@
 #include <algorithm>
 #include <exception>
 #include <fstream>
+#include <limits>
+#include <unordered_set>
 #include <vector>
 
+#include "Blueprint.hpp"
+#include "ChunkBuilder.hpp"
+#include "Fixed.hpp"
+#include "GridLayout.hpp"
 #include "KeyManager.hpp"
 #include "MaterialManager.hpp"
+#include "Minimap.hpp"
+#include "ModifiedStat.hpp"
+#include "TextureAtlas.hpp"
 #include "Tilemap.hpp"
 #include "nlohmann/json.hpp"
 
@@ -37,7 +46,7 @@ public:
 	 *
 	 * @see initBuildings()
 	 */
-	BuildingManager(Tilemap *map);
+	BuildingManager(Tilemap *map, const TextureAtlas *atlas);
 
 	/**
 	 * @brief Simple typedef to make building usage easier.
@@ -45,14 +54,96 @@ public:
 	 */
 	typedef nlohmann::json Building;
 
+	/**
+	 * @brief Index of a building type, in the order they were loaded.
+	 *
+	 */
+	typedef unsigned BuildingID;
+
+	/**
+	 * @brief A production bonus from nearby buildings of one type.
+	 *
+	 */
+	struct Bonus
+	{
+		/// The mInfluences field counting the nearby buildings.
+		unsigned field;
+		/// The output multiplier added per nearby building.
+		Fixed per;
+		/// The most nearby buildings that count.
+		unsigned max;
+	};
+
+	/**
+	 * @brief Pre-resolved numeric stats of a building type.
+	 *
+	 * @remarks Base values come from object_data.json & never change.
+	 * Upgrades push modifiers, and the tick & GUI read the cached results.
+	 */
+	struct BuildingStats
+	{
+		ModifiedCost price;
+		ModifiedCost sellprice;
+		ModifiedCost resource_in;
+		ModifiedCost resource_out;
+		/// The price's entry in the MaterialManager affordability cache.
+		MaterialManager::PurchasableID purchasable;
+		/// True for every tile ID the building can be placed on.
+		std::vector<bool> canbuildon;
+		/// The size of the building's bounding box, in tiles.
+		sf::Vector2i footprint;
+		/// The offset of every tile the building covers, from its top left.
+		std::vector<sf::Vector2i> cells;
+		/// The bonuses the building gets from its neighbours.
+		std::vector<Bonus> bonuses;
+		/// The mInfluences fields the building is counted in.
+		std::vector<unsigned> influences;
+		/// The resource taken from the tiles under it per tick, or 0 if it
+		/// doesn't need any.
+		unsigned extracts;
+	};
+
+	/**
+	 * @brief A pre-formatted tooltip line, drawn as an icon & text.
+	 *
+	 */
+	struct TooltipLine
+	{
+		sf::Sprite icon;
+		std::string text;
+	};
+
+	/**
+	 * @brief Pre-formatted tooltip contents of a building type.
+	 *
+	 * @remarks The name, description & placeable tiles never change. The cost
+	 * lines are reformatted only after the building is upgraded.
+	 */
+	struct BuildingTooltip
+	{
+		std::string name;
+		std::vector<std::string> description;
+		std::vector<TooltipLine> canbuildon;
+		/// True if the cost lines need reformatting.
+		bool dirty;
+		std::vector<TooltipLine> price;
+		std::vector<TooltipLine> sellprice;
+		std::vector<TooltipLine> resource_in;
+		std::vector<TooltipLine> resource_out;
+	};
+
 	/**
 	 * @brief Placed building data.
 	 *
 	 */
 	struct BuildingEntityData
 	{
-		sf::Sprite spr;
-		Building *building_data;
+		BuildingID id;
+		/// The building's top left tile index in the map grid.
+		unsigned tile;
+		/// The output multiplier from its bonuses, kept up to date as
+		/// neighbours come & go.
+		Fixed multiplier;
 	};
 
 	/**
@@ -69,6 +160,26 @@ public:
 	 */
 	MaterialManager *getMaterialManager();
 
+	/**
+	 * @brief Return the texture atlas.
+	 *
+	 * @return const TextureAtlas* A pointer to the main game texture atlas.
+	 */
+	const TextureAtlas *getAtlas();
+
+	/**
+	 * @brief Get the average color of every building's sprite, by ID.
+	 *
+	 */
+	std::vector<sf::Color> getBuildingColors();
+
+	/**
+	 * @brief Let a minimap read the buildings off the occupancy grid, & tell
+	 * it which tiles are placed on & sold.
+	 *
+	 */
+	void attachMinimap(Minimap *minimap);
+
 	/**
 	 * @brief Renders the necessary gui components.
 	 *
@@ -79,6 +190,14 @@ public:
 	 */
 	void renderGuiBuildings();
 
+	/**
+	 * @brief Renders the blueprint copy, paste, save & load buttons.
+	 *
+	 * @remarks CALL ImGui::Begin() BEFOREHAND.
+	 *
+	 */
+	void renderGuiBlueprints();
+
 	/**
 	 * @brief Renders the resources to the active ImGui context.
 	 *
@@ -100,6 +219,19 @@ public:
 	 */
 	void update();
 
+	/**
+	 * @brief Returns true, once, if something visible changed since the last
+	 * call, such as a tick or a building being placed or sold.
+	 *
+	 */
+	bool pollChanged();
+
+	/**
+	 * @brief The time left before the next tick.
+	 *
+	 */
+	sf::Time getTimeUntilTick() const;
+
 private:
 	/**
 	 * @brief SFML draw() override.
@@ -119,6 +251,12 @@ private:
 	 */
 	sf::Clock mTickClock;
 
+	/**
+	 * @brief True if something visible changed since the last pollChanged().
+	 *
+	 */
+	bool mChanged;
+
 	/**
 	 * @brief Clock that's never reset, logging the total game time elapsed.
 	 *
@@ -134,8 +272,35 @@ private:
 	/**
 	 * @brief The ticks per second.
 	 *
+	 * @remarks Fixed-point, so upgrades modify it deterministically.
+	 */
+	ModifiedStat<Fixed> mTPS;
+
+	/**
+	 * @brief The count of ticks since the game started.
+	 *
+	 */
+	unsigned long long mTickCount;
+
+	/**
+	 * @brief The earliest tick a timed modifier expires on, 0 if none.
+	 *
+	 */
+	unsigned long long mNextExpiry;
+
+	/**
+	 * @brief Removes expired modifiers from every stat, and finds the next
+	 * expiry.
+	 *
 	 */
-	float mTPS;
+	void expireModifiers();
+
+	/**
+	 * @brief Pushes every building's current price to the affordability
+	 * cache. Call after price modifiers change.
+	 *
+	 */
+	void refreshPrices();
 
 	/**
 	 * @brief Internal reference to the tilemap, to retrieve tile properties.
@@ -149,12 +314,171 @@ private:
 	 */
 	std::vector<Building> mBuildings;
 
+	/**
+	 * @brief The stats of each building, indexed by BuildingID.
+	 *
+	 */
+	std::vector<BuildingStats> mStats;
+
 	/**
 	 * @brief Vector of placed building data, for the actual rendered buildings.
 	 *
+	 * @remarks Unordered, selling compacts the survivors over the gaps.
 	 */
 	std::vector<BuildingEntityData> mBuilt;
 
+	/**
+	 * @brief The index in mBuilt of the building on each map tile, or -1.
+	 *
+	 * @remarks Stored in mLayout order, access through getOccupant().
+	 */
+	std::vector<int> mOccupancy;
+
+	/**
+	 * @brief The layout of mOccupancy.
+	 *
+	 */
+	GridLayout mLayout;
+
+	/**
+	 * @brief Get the mOccupancy entry of a map tile.
+	 *
+	 * @param tile The tile's row-major index.
+	 */
+	int &getOccupant(unsigned tile);
+
+	/**
+	 * @brief How many buildings of one type are near each tile.
+	 *
+	 * @remarks Placing a building adds 1 over every tile within radius of its
+	 * footprint, & selling it takes 1 off again, so counts are only touched
+	 * around the buildings that changed.
+	 */
+	struct Influence
+	{
+		BuildingID from;
+		int radius;
+		/// The count at each tile, in mLayout order.
+		std::vector<unsigned> counts;
+	};
+
+	/**
+	 * @brief Every neighbour count a bonus needs, one per type & radius.
+	 *
+	 */
+	std::vector<Influence> mInfluences;
+
+	/**
+	 * @brief Get the mInfluences field of a type & radius, adding it if new.
+	 *
+	 */
+	unsigned getInfluence(BuildingID from, int radius);
+
+	/**
+	 * @brief Add or take a building off the neighbour counts it's in, &
+	 * update the multiplier of every building around it.
+	 *
+	 * @param building The building's index in mBuilt.
+	 * @param delta 1 when placed, -1 when removed.
+	 */
+	void spreadInfluence(unsigned building, int delta);
+
+	/**
+	 * @brief Recompute a building's multiplier from the neighbour counts.
+	 *
+	 * @param building The building's index in mBuilt.
+	 */
+	void updateMultiplier(unsigned building);
+
+	/**
+	 * @brief The width & height of a render chunk, in tiles.
+	 *
+	 */
+	const int CHUNK_SIZE = 16;
+
+	/**
+	 * @brief The number of render chunks across & down the map.
+	 *
+	 */
+	sf::Vector2i mChunkCount;
+
+	/**
+	 * @brief Builds the quads of every building in each chunk on a worker
+	 * thread. Each chunk is drawn in one call.
+	 *
+	 */
+	ChunkBuilder mChunkBuilder;
+
+	/**
+	 * @brief The minimap to update when buildings change, or nullptr.
+	 *
+	 */
+	Minimap *mMinimap;
+
+	/**
+	 * @brief Get the map tile index of a position, or -1 if it's off the map.
+	 *
+	 */
+	int getTileIndex(sf::Vector2f pos);
+
+	/**
+	 * @brief Place a building on every given tile, & queue their chunks for
+	 * rebuilding.
+	 *
+	 * @remarks The tiles must be placeable & paid for.
+	 */
+	void addBuilt(BuildingID id, const std::vector<unsigned> &tiles);
+
+	/**
+	 * @brief Remove the buildings at the given indices of mBuilt, & queue
+	 * their chunks for rebuilding.
+	 *
+	 * @remarks mBuilt is compacted in a single pass from the first removed
+	 * index, keeping the survivors' order. Indices may repeat.
+	 */
+	void removeBuilt(const std::vector<unsigned> &indices);
+
+	/**
+	 * @brief Get the region between two tiles, inclusive.
+	 *
+	 */
+	static sf::IntRect getDragRegion(sf::Vector2i a, sf::Vector2i b);
+
+	/**
+	 * @brief True while the right mouse button is held over the map,
+	 * dragging out a region to sell.
+	 *
+	 */
+	bool mSelling;
+
+	/**
+	 * @brief The tiles the sell drag started & last hovered on.
+	 *
+	 */
+	sf::Vector2i mSellStart;
+	sf::Vector2i mSellEnd;
+
+	/**
+	 * @brief The rectangle drawn over the region being sold.
+	 *
+	 */
+	sf::RectangleShape mSellRect;
+
+	/**
+	 * @brief Tracks the sell drag, & sells every building in the region
+	 * when it's released.
+	 *
+	 */
+	void updateSelling();
+
+	/**
+	 * @brief Sell every building in a region, refunding their sell prices in
+	 * one transaction.
+	 *
+	 * @param region The region, in tiles.
+	 */
+	void sellRegion(sf::IntRect region);
+
 	/**
 	 * @brief Renders the tooltip for the given building to GUI.
 	 *
@@ -162,6 +486,41 @@ private:
 	 */
 	void renderGuiBuilding(Building &building, bool isHighlightedOnMap = false);
 
+	/**
+	 * @brief The tooltip of each building, indexed by BuildingID.
+	 *
+	 */
+	std::vector<BuildingTooltip> mTooltips;
+
+	/**
+	 * @brief Returns the tooltip of a building, reformatting its costs if
+	 * they're out of date.
+	 *
+	 */
+	const BuildingTooltip &getTooltip(BuildingID id);
+
+	/**
+	 * @brief Flags a building's tooltip costs for reformatting. Call after
+	 * modifying its stats.
+	 *
+	 */
+	void invalidateTooltip(BuildingID id);
+
+	/**
+	 * @brief Formats an icon, count & name line for every resource in the
+	 * cost, along with the base count if upgrades have modified it.
+	 *
+	 * @param cost The resources to format.
+	 * @param out The lines to overwrite.
+	 */
+	void formatCost(const ModifiedCost &cost, std::vector<TooltipLine> &out);
+
+	/**
+	 * @brief Renders pre-formatted tooltip lines.
+	 *
+	 */
+	void renderGuiLines(const std::vector<TooltipLine> &lines);
+
 	/**
 	 * @brief Initializes the material manager & the mBuildings vector.
 	 *
@@ -169,12 +528,50 @@ private:
 	 */
 	bool initBuildings();
 
+	/**
+	 * @brief Read a building's footprint into its stats.
+	 *
+	 * @param name The building's name, for errors.
+	 * @param data The building's "footprint" object.
+	 *
+	 * @throws std::runtime_error If the size or mask is invalid.
+	 */
+	void parseFootprint(const std::string &name,
+						const nlohmann::json &data,
+						BuildingStats &stats);
+
+	/**
+	 * @brief Read every building's bonuses, once all the buildings are loaded.
+	 *
+	 * @throws std::out_of_range If a bonus names an unknown building.
+	 */
+	void initBonuses();
+
 	/**
 	 * @brief Updates a single game tick.
 	 *
 	 */
 	void updateTick();
 
+	/**
+	 * @brief Scratch space for a building's multiplied output.
+	 *
+	 */
+	MaterialManager::Cost mScaledOutput;
+
+	/**
+	 * @brief The tiles emptied this tick, applied to the map together.
+	 *
+	 */
+	TileEditBatch mConversions;
+
+	/**
+	 * @brief Get the first tile under a building with resource left.
+	 *
+	 * @return int The tile's row-major index, or -1 if it's all used up.
+	 */
+	int getExtractTile(const BuildingEntityData &building);
+
 	/**
 	 * @brief Returns the amount of buildings of the specified name are built.
 	 *
@@ -183,34 +580,60 @@ private:
 	 */
 	int getBuildingCount(std::string building_name);
 
+	/**
+	 * @brief The number of each building currently built, indexed by
+	 * BuildingID.
+	 *
+	 */
+	std::vector<int> mBuiltCounts;
+
 	/**
 	 * @brief Returns a pointer to the building with the given name.
 	 * 
-	 * @return Building* 
+	 * @return Building* The building, or nullptr if it doesn't exist.
 	 */
 	Building *getBuilding(std::string building_name);
 
 	/**
-	 * @brief Map of building names to their textures.
+	 * @brief Returns the ID of the building with the given name.
+	 *
+	 * @throws std::out_of_range If the building doesn't exist.
+	 */
+	BuildingID getBuildingID(std::string building_name);
+
+	/**
+	 * @brief Returns the ID of a building in mBuildings.
+	 *
+	 */
+	BuildingID getBuildingID(const Building &building);
+
+	/**
+	 * @brief The atlas containing every building texture.
 	 *
 	 */
-	std::unordered_map<std::string, sf::Texture> mBuildingTextures;
+	const TextureAtlas *mAtlas;
 
 	/**
-	 * @brief Get the texture of the given building.
+	 * @brief The sprite of each building, indexed by BuildingID.
+	 *
+	 */
+	std::vector<sf::Sprite> mBuildingSprites;
+
+	/**
+	 * @brief Get the sprite of the given building.
 	 *
 	 * @param building_name The name of the building.
-	 * @return sf::Texture* A pointer to the required texture.
+	 * @return const sf::Sprite& The building's sprite, from the atlas.
 	 */
-	sf::Texture *getBuildingTexture(std::string building_name);
+	const sf::Sprite &getBuildingSprite(std::string building_name);
 
 	/**
-	 * @brief Get the texture of the given building.
+	 * @brief Get the sprite of the given building.
 	 *
 	 * @param building The building.
-	 * @return sf::Texture* A pointer to the building's texture.
+	 * @return const sf::Sprite& The building's sprite, from the atlas.
 	 */
-	sf::Texture *getBuildingTexture(Building &building);
+	const sf::Sprite &getBuildingSprite(Building &building);
 
 	/**
 	 * @brief True if currently in "build mode" -- dragging tower for placement.
@@ -245,6 +668,168 @@ private:
 	 */
 	void releaseBuilding();
 
+	/**
+	 * @brief True while the left mouse button is held in build mode,
+	 * dragging out a region to place in.
+	 *
+	 */
+	bool mDragging;
+
+	/**
+	 * @brief The tiles the drag started & last hovered on.
+	 *
+	 */
+	sf::Vector2i mDragStart;
+	sf::Vector2i mDragEnd;
+
+	/**
+	 * @brief Get every tile in a region the building can be placed on, in
+	 * row order.
+	 *
+	 * @param region The region, in tiles. Buildings are tried a footprint
+	 * apart, starting from its top left.
+	 */
+	std::vector<unsigned> getPlaceableTiles(BuildingID id, sf::IntRect region);
+
+	/**
+	 * @brief Get how many of a building can be bought at once, up to count.
+	 *
+	 */
+	unsigned getAffordableCount(BuildingID id, unsigned count);
+
+	/**
+	 * @brief Get the summed price of many buildings, one entry per resource.
+	 *
+	 * @param counts How many of each building, indexed by BuildingID.
+	 */
+	MaterialManager::Cost getTotalPrice(const std::vector<unsigned> &counts);
+
+	//////////////////////BLUEPRINTS/////////////////////////
+
+	/**
+	 * @brief What the mouse does with blueprints.
+	 *
+	 */
+	enum class BlueprintMode
+	{
+		/// Not using blueprints.
+		None,
+		/// Dragging out a region to copy.
+		Capture,
+		/// Holding the copied blueprint to paste.
+		Paste
+	};
+
+	/**
+	 * @brief The current blueprint mode.
+	 *
+	 */
+	BlueprintMode mBlueprintMode;
+
+	/**
+	 * @brief The last copied or loaded blueprint.
+	 *
+	 */
+	Blueprint mBlueprint;
+
+	/**
+	 * @brief Where blueprints are saved & loaded.
+	 *
+	 */
+	const std::string BLUEPRINT_PATH = "resource/blueprints/blueprint.json";
+
+	/**
+	 * @brief The result of the last save or load, shown in the GUI.
+	 *
+	 */
+	std::string mBlueprintStatus;
+
+	/**
+	 * @brief The tile the blueprint's top left was last validated at.
+	 *
+	 */
+	sf::Vector2i mPasteAnchor;
+
+	/**
+	 * @brief The size of the blueprint including its buildings' footprints,
+	 * in tiles.
+	 *
+	 */
+	sf::Vector2i mPasteSize;
+
+	/**
+	 * @brief True if the paste must be revalidated, even at the same anchor.
+	 *
+	 */
+	bool mPasteDirty;
+
+	/**
+	 * @brief The map tile of each blueprint cell, or -1 if it can't be placed.
+	 *
+	 */
+	std::vector<int> mPasteTiles;
+
+	/**
+	 * @brief The tiles claimed by earlier cells, while validating a paste.
+	 *
+	 * @remarks Kept between calls, so validating only allocates once the
+	 * blueprint outgrows it.
+	 */
+	std::unordered_set<unsigned> mPasteClaimed;
+
+	/**
+	 * @brief The summed price of every placeable cell.
+	 *
+	 */
+	MaterialManager::Cost mPastePrice;
+
+	/**
+	 * @brief The translucent preview of the blueprint, under the mouse.
+	 *
+	 */
+	sf::VertexArray mGhost;
+
+	/**
+	 * @brief Called by update(), tracks the capture drag & pastes on click.
+	 *
+	 */
+	void updateBlueprint();
+
+	/**
+	 * @brief Copy every building in a region into mBlueprint.
+	 *
+	 * @param region The region, in tiles.
+	 */
+	void captureBlueprint(sf::IntRect region);
+
+	/**
+	 * @brief Check every cell of the blueprint at an anchor in one pass,
+	 * price the placeable ones, & rebuild the ghost.
+	 *
+	 * @param anchor The tile under the blueprint's top left.
+	 */
+	void validatePaste(sf::Vector2i anchor);
+
+	/**
+	 * @brief Buy & place every placeable cell of the validated paste, in one
+	 * transaction.
+	 *
+	 * @return true If anything was placed.
+	 */
+	bool pasteBlueprint();
+
+	/**
+	 * @brief Save mBlueprint to BLUEPRINT_PATH.
+	 *
+	 */
+	bool saveBlueprint();
+
+	/**
+	 * @brief Load mBlueprint from BLUEPRINT_PATH.
+	 *
+	 */
+	bool loadBlueprint();
+
 	/**
 	 * @brief The sprite rendered when dragging & dropping the building.
 	 *
@@ -266,7 +851,89 @@ private:
 		{"DEFAULT",
 		 sf::Color(255, 255, 255, 130)},
 		{"INVALID",
-		 sf::Color(255, 65, 65, 130)}};
+		 sf::Color(255, 65, 65, 130)},
+		{"PLACEABLE",
+		 sf::Color(120, 255, 120, 60)},
+		{"SELL",
+		 sf::Color(255, 65, 65, 80)}};
+
+	/**
+	 * @brief Check if a building can be placed with its top left on a tile,
+	 * ignoring its price.
+	 *
+	 * @remarks Every covered tile must be on the map, placeable & free.
+	 *
+	 * @param id The building.
+	 * @param tile The tile's row-major index.
+	 */
+	bool canPlace(BuildingID id, unsigned tile);
+
+	/**
+	 * @brief Visit every tile a building covers, as f(unsigned tile).
+	 *
+	 * @remarks The footprint isn't clipped to the map.
+	 *
+	 * @param id The building.
+	 * @param tile The row-major index of its top left tile.
+	 */
+	template <class F>
+	void forFootprint(BuildingID id, unsigned tile, F f)
+	{
+		int width = mMap->getGridSize().x;
+		for (sf::Vector2i offset : mStats[id].cells)
+		{
+			f(tile + offset.y * width + offset.x);
+		}
+	}
+
+	/**
+	 * @brief The largest footprint of any building, in tiles.
+	 *
+	 */
+	sf::Vector2i mMaxFootprint;
+
+	/**
+	 * @brief The building the placement overlay was built for, or -1.
+	 *
+	 */
+	int mOverlayBuilding;
+
+	/**
+	 * @brief A quad over every tile the held building can be placed on, one
+	 * vertex array per render chunk.
+	 *
+	 * @remarks Only the chunks in mOverlayBuilt hold any.
+	 */
+	std::vector<sf::VertexArray> mOverlayChunks;
+
+	/**
+	 * @brief The chunks holding overlay quads, which were in view last
+	 * update.
+	 *
+	 */
+	std::vector<unsigned> mOverlayBuilt;
+
+	/**
+	 * @brief True for every chunk whose overlay is missing or out of date.
+	 *
+	 */
+	std::vector<bool> mOverlayChunkDirty;
+
+	/**
+	 * @brief Flag the overlay of a tile's render chunk for rebuilding.
+	 *
+	 * @param tile The tile's row-major index.
+	 */
+	void markOverlayDirty(unsigned tile);
+
+	/**
+	 * @brief Rebuild the overlay of every dirty chunk in view, for the held
+	 * building, & free the overlay of chunks out of view.
+	 *
+	 * @remarks Chunks are built the first time they come into view, so
+	 * picking up a building costs only the chunks on screen.
+	 */
+	void updateOverlay();
 
 	/**
 	 * @brief True if the HighlightRect should be drawn.
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Builds the vertex arrays of chunked, tile-aligned sprites on a
+ * worker thread.
+ *
+ * @remarks The main thread queues tile edits with setTile(), hands them over
+ * once per frame with flush(), and swaps finished chunks into the front
+ * buffers with collect(). The worker keeps the sprites of each chunk as a
+ * short list rather than a copy of the grid, so the two threads share only
+ * the edit queue & the finished chunks.
+ *
+ */
+class ChunkBuilder
+{
+public:
+	/**
+	 * @brief Default constructor. Call init() before use.
+	 *
+	 */
+	ChunkBuilder();
+
+	/**
+	 * @brief Stops & joins the worker thread.
+	 *
+	 */
+	~ChunkBuilder();
+
+	/**
+	 * @brief Size the grid & start the worker thread.
+	 *
+	 * @param grid The size of the grid, in tiles.
+	 * @param tile_size The size of a tile, in pixels.
+	 * @param chunk_size The width & height of a chunk, in tiles.
+	 * @param sprites The texture rect of each sprite ID.
+	 * @param footprints The size of each sprite ID, in tiles. Sprites are
+	 * stretched over it from their tile.
+	 */
+	void init(sf::Vector2i grid,
+			  sf::Vector2f tile_size,
+			  int chunk_size,
+			  std::vector<sf::IntRect> sprites,
+			  std::vector<sf::Vector2i> footprints);
+
+	/**
+	 * @brief Queue setting a tile's sprite.
+	 *
+	 * @param tile The tile's index in the grid.
+	 * @param sprite The sprite ID, or -1 to clear the tile.
+	 */
+	void setTile(unsigned tile, int sprite);
+
+	/**
+	 * @brief Hand all queued edits to the worker. Call once per frame.
+	 *
+	 */
+	void flush();
+
+	/**
+	 * @brief Swap every chunk the worker has finished into the front buffers.
+	 *
+	 * @return true If any chunk changed.
+	 */
+	bool collect();
+
+	/**
+	 * @brief The front buffers, one vertex array of quads per chunk.
+	 *
+	 */
+	const std::vector<sf::VertexArray> &getChunks() const;
+
+private:
+	/**
+	 * @brief The worker thread's main loop.
+	 *
+	 */
+	void run();
+
+	/**
+	 * @brief Apply an edit to the worker's sprite lists.
+	 *
+	 * @return unsigned The edited tile's chunk.
+	 */
+	unsigned applyEdit(std::pair<unsigned, int> edit);
+
+	/**
+	 * @brief Generate a chunk's quads from its sprite list.
+	 *
+	 */
+	void buildChunk(unsigned chunk, sf::VertexArray &out);
+
+	///////////////SETTINGS///////////////
+	sf::Vector2i mGrid;
+	sf::Vector2f mTileSize;
+	int mChunkSize;
+	sf::Vector2i mChunkCount;
+	std::vector<sf::IntRect> mSprites;
+	std::vector<sf::Vector2i> mFootprints;
+
+	///////////////MAIN THREAD///////////////
+
+	/**
+	 * @brief Edits queued since the last flush().
+	 *
+	 */
+	std::vector<std::pair<unsigned, int>> mPending;
+
+	/**
+	 * @brief The chunks drawn by the main thread.
+	 *
+	 */
+	std::vector<sf::VertexArray> mFront;
+
+	///////////////SHARED, GUARDED BY mMutex///////////////
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	bool mStop;
+
+	/**
+	 * @brief Edits flushed to the worker, not yet applied.
+	 *
+	 */
+	std::vector<std::pair<unsigned, int>> mQueue;
+
+	/**
+	 * @brief Chunks the worker has finished, not yet collected.
+	 *
+	 */
+	std::vector<std::pair<unsigned, sf::VertexArray>> mReady;
+
+	///////////////WORKER THREAD///////////////
+
+	/**
+	 * @brief The (tile, sprite ID) pairs set in each chunk, unordered.
+	 *
+	 * @remarks As long as the number of sprites, rather than the grid.
+	 */
+	std::vector<std::vector<std::pair<unsigned, int>>> mChunkSprites;
+
+	/**
+	 * @brief True for chunks touched by the edits being applied.
+	 *
+	 */
+	std::vector<bool> mChunkDirty;
+
+	std::thread mThread;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "nlohmann/json.hpp"
+
+#include "BigNumber.hpp"
+
+/**
+ * @brief Signed 32.32 fixed-point number, used for every multiplier & rate
+ * in the economy (price factors, upgrade operands, TPS).
+ *
+ * @remarks All arithmetic is integer-only, so results are bit-exact across
+ * platforms & compilers. Floats are only produced for display & timing.
+ *
+ */
+class Fixed
+{
+public:
+	/**
+	 * @brief The count of fractional bits.
+	 *
+	 */
+	static const int FRACTION_BITS = 32;
+
+	/**
+	 * @brief Default constructor, initializes to 0.
+	 *
+	 */
+	Fixed();
+
+	/**
+	 * @brief Construct from a whole number.
+	 *
+	 * @param whole The integer value.
+	 */
+	Fixed(long long whole);
+
+	/**
+	 * @brief Construct directly from the raw 32.32 representation.
+	 *
+	 */
+	static Fixed fromRaw(int64_t raw);
+
+	/**
+	 * @brief Convert from a double, rounding to the nearest 2^-32.
+	 *
+	 * @remarks Only use when loading data, never inside the simulation.
+	 */
+	static Fixed fromDouble(double value);
+
+	/**
+	 * @brief Parse a decimal string (ex: "-1.25") without going through
+	 * floating point.
+	 *
+	 * @throws std::invalid_argument If the string is not a valid number.
+	 */
+	static Fixed fromString(const std::string &str);
+
+	/**
+	 * @brief Retrieve the raw 32.32 representation.
+	 *
+	 */
+	int64_t raw() const;
+
+	/**
+	 * @brief Convert to a double, for display & timing only.
+	 *
+	 */
+	double toDouble() const;
+
+	/**
+	 * @brief Round to the nearest whole number, halves away from zero.
+	 *
+	 */
+	BigNumber round() const;
+
+	Fixed &operator+=(const Fixed &rhs);
+	Fixed &operator-=(const Fixed &rhs);
+	Fixed &operator*=(const Fixed &rhs);
+	Fixed &operator/=(const Fixed &rhs);
+
+	friend Fixed operator+(Fixed lhs, const Fixed &rhs);
+	friend Fixed operator-(Fixed lhs, const Fixed &rhs);
+	friend Fixed operator*(Fixed lhs, const Fixed &rhs);
+	friend Fixed operator/(Fixed lhs, const Fixed &rhs);
+
+	friend bool operator==(const Fixed &lhs, const Fixed &rhs);
+	friend bool operator!=(const Fixed &lhs, const Fixed &rhs);
+	friend bool operator<(const Fixed &lhs, const Fixed &rhs);
+	friend bool operator>(const Fixed &lhs, const Fixed &rhs);
+	friend bool operator<=(const Fixed &lhs, const Fixed &rhs);
+	friend bool operator>=(const Fixed &lhs, const Fixed &rhs);
+
+private:
+	/**
+	 * @brief The raw 32.32 value.
+	 *
+	 */
+	int64_t mRaw;
+};
+
+/**
+ * @brief Scale a count by a multiplier, rounding the result to the nearest
+ * whole number (halves away from zero) & saturating on overflow.
+ *
+ */
+BigNumber operator*(const BigNumber &lhs, const Fixed &rhs);
+
+/**
+ * @brief Divide a count by a multiplier, rounding the result to the nearest
+ * whole number (halves away from zero) & saturating on overflow or division
+ * by zero.
+ *
+ */
+BigNumber operator/(const BigNumber &lhs, const Fixed &rhs);
+
+/**
+ * @brief nlohmann::json serializer. Writes whole values as integers, anything
+ * else as an exact decimal string.
+ *
+ */
+void to_json(nlohmann::json &j, const Fixed &f);
+
+/**
+ * @brief nlohmann::json deserializer. Accepts integers, floats & decimal
+ * strings.
+ *
+ */
+void from_json(const nlohmann::json &j, Fixed &f);
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+
+/**
+ * @brief Maps grid positions to storage indices, in square chunks with each
+ * chunk's tiles in Z-order (Morton order).
+ *
+ * @remarks Neighbouring tiles stay close in memory in both axes, so 2D scans
+ * touch far fewer cache lines than a row-major layout. Callers should go
+ * through forRow(), forRect() & forRadius(), which visit tiles chunk by chunk,
+ * instead of assuming an order.
+ *
+ * @remarks The visitors call f(sf::Vector2i pos, unsigned index), where index
+ * is the storage index of pos. Positions outside the grid are skipped.
+ *
+ */
+class GridLayout
+{
+public:
+	/**
+	 * @brief The width & height of a chunk, in tiles. A power of two.
+	 *
+	 */
+	static const int CHUNK_SIZE = 32;
+
+	/**
+	 * @brief The number of tiles, & storage indices, in a chunk.
+	 *
+	 */
+	static const unsigned CHUNK_TILES = CHUNK_SIZE * CHUNK_SIZE;
+
+	/**
+	 * @brief Default constructor, of an empty grid.
+	 *
+	 */
+	GridLayout();
+
+	/**
+	 * @brief Construct the layout of a grid.
+	 *
+	 * @param size The size of the grid, in tiles.
+	 */
+	GridLayout(sf::Vector2i size);
+
+	/**
+	 * @brief Get the size of the grid, in tiles.
+	 *
+	 */
+	sf::Vector2i getSize() const;
+
+	/**
+	 * @brief Get the size of the grid, in chunks.
+	 *
+	 */
+	sf::Vector2i getChunkCount() const;
+
+	/**
+	 * @brief Get the length storage needs, including the padding of partial
+	 * chunks.
+	 *
+	 */
+	unsigned getStorageSize() const;
+
+	/**
+	 * @brief Check if a position is inside the grid.
+	 *
+	 */
+	bool contains(sf::Vector2i pos) const;
+
+	/**
+	 * @brief Get the storage index of a tile.
+	 *
+	 * @param pos The tile's position, which must be inside the grid.
+	 */
+	unsigned index(sf::Vector2i pos) const
+	{
+		unsigned chunk = (pos.y / CHUNK_SIZE) * mChunkCount.x + (pos.x / CHUNK_SIZE);
+		return chunk * CHUNK_TILES +
+			   interleave(pos.x % CHUNK_SIZE, pos.y % CHUNK_SIZE);
+	}
+
+	/**
+	 * @brief Get the storage index of a tile.
+	 *
+	 * @param tile The tile's row-major index.
+	 */
+	unsigned index(unsigned tile) const
+	{
+		return index(sf::Vector2i(tile % mSize.x, tile / mSize.x));
+	}
+
+	/**
+	 * @brief Get the Z-order index of a position within a chunk.
+	 *
+	 */
+	static unsigned interleave(unsigned x, unsigned y)
+	{
+		return spread(x) | (spread(y) << 1);
+	}
+
+	/**
+	 * @brief Visit the tiles of a row, from x to x + width.
+	 *
+	 */
+	template <class F>
+	void forRow(int y, int x, int width, F f) const
+	{
+		forRect(sf::IntRect(x, y, width, 1), f);
+	}
+
+	/**
+	 * @brief Visit every tile in a rectangle, chunk by chunk.
+	 *
+	 */
+	template <class F>
+	void forRect(sf::IntRect rect, F f) const
+	{
+		// Clip to the grid.
+		int left   = std::max(rect.left, 0);
+		int top	   = std::max(rect.top, 0);
+		int right  = std::min(rect.left + rect.width, mSize.x);
+		int bottom = std::min(rect.top + rect.height, mSize.y);
+		if (left >= right || top >= bottom)
+		{
+			return;
+		}
+
+		for (int cy = top / CHUNK_SIZE; cy <= (bottom - 1) / CHUNK_SIZE; ++cy)
+		{
+			for (int cx = left / CHUNK_SIZE; cx <= (right - 1) / CHUNK_SIZE; ++cx)
+			{
+				unsigned base = (cy * mChunkCount.x + cx) * CHUNK_TILES;
+
+				// The part of the rect inside this chunk.
+				int x0 = std::max(left, cx * CHUNK_SIZE);
+				int x1 = std::min(right, (cx + 1) * CHUNK_SIZE);
+				int y0 = std::max(top, cy * CHUNK_SIZE);
+				int y1 = std::min(bottom, (cy + 1) * CHUNK_SIZE);
+				unsigned first_x = spread(x0 % CHUNK_SIZE);
+				for (int y = y0; y < y1; ++y)
+				{
+					unsigned row = base | (spread(y % CHUNK_SIZE) << 1);
+
+					// Step along the x bits, carrying through the y bits.
+					unsigned mx = first_x;
+					for (int x = x0; x < x1; ++x)
+					{
+						f(sf::Vector2i(x, y), row | mx);
+						mx = ((mx | ~X_BITS) + 1) & X_BITS;
+					}
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Visit every tile whose center is within radius tiles of the
+	 * center of another, chunk by chunk.
+	 *
+	 */
+	template <class F>
+	void forRadius(sf::Vector2i center, int radius, F f) const
+	{
+		sf::IntRect bounds(center.x - radius,
+						   center.y - radius,
+						   radius * 2 + 1,
+						   radius * 2 + 1);
+		forRect(bounds, [&](sf::Vector2i pos, unsigned index) {
+			int dx = pos.x - center.x;
+			int dy = pos.y - center.y;
+			if (dx * dx + dy * dy <= radius * radius)
+			{
+				f(pos, index);
+			}
+		});
+	}
+
+private:
+	/**
+	 * @brief The size of the grid, in tiles.
+	 *
+	 */
+	sf::Vector2i mSize;
+
+	/**
+	 * @brief The size of the grid, in chunks.
+	 *
+	 */
+	sf::Vector2i mChunkCount;
+
+	/**
+	 * @brief The bits of a Z-order index that hold the x coordinate.
+	 *
+	 */
+	static const unsigned X_BITS = 0x5555 & (CHUNK_TILES - 1);
+
+	/**
+	 * @brief Spread the bits of a chunk coordinate to every other bit.
+	 *
+	 */
+	static unsigned spread(unsigned v)
+	{
+		v = (v | (v << 4)) & 0x0F0F;
+		v = (v | (v << 2)) & 0x3333;
+		v = (v | (v << 1)) & 0x5555;
+		return v;
+	}
+};
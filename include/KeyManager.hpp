@@ -1,12 +1,15 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include <unordered_map>
+#include <bitset>
 
 /**
  * @brief Simple mostly static KeyManager class for retrieving the state of the
  * keyboard & mouse globally.
  *
+ * @remarks State is built from window events, rather than polling every key.
+ * Pass every event to handleEvent(), then call update() once per frame.
+ *
  */
 class KeyManager
 {
@@ -22,7 +25,15 @@ public:
 	static void setWindowReference(sf::RenderWindow *mWindowPtr);
 
 	/**
-	 * @brief Main key updating function. Call once per frame.
+	 * @brief Record a key, mouse button, mouse move or focus event.
+	 *
+	 * @param event An event polled from the window.
+	 */
+	static void handleEvent(const sf::Event &event);
+
+	/**
+	 * @brief Main key updating function. Call once per frame, after handling
+	 * that frame's events.
 	 *
 	 */
 	static void update();
@@ -34,6 +45,27 @@ public:
 	 */
 	static sf::Vector2i getMousePos();
 
+	/**
+	 * @brief Set the view the map is drawn with, for getMapMousePos().
+	 *
+	 */
+	static void setMapView(const sf::View *view);
+
+	/**
+	 * @brief Retrieve the mouse position in map coordinates.
+	 *
+	 * @return sf::Vector2f The position, or (-1, -1) if the mouse is outside
+	 * the map view's viewport.
+	 */
+	static sf::Vector2f getMapMousePos();
+
+	/**
+	 * @brief Retrieve the area of the map in view, in map coordinates.
+	 *
+	 * @return sf::FloatRect The area, or an empty rect if no map view is set.
+	 */
+	static sf::FloatRect getMapArea();
+
 	/**
 	 * @brief Retrieve the LMB state.
 	 *
@@ -73,20 +105,69 @@ private:
 	static sf::RenderWindow *mWindowPtr;
 
 	/**
-	 * @brief A map of keys and their respective current state.
+	 * @brief Keys currently held down, indexed by key code.
+	 *
+	 */
+	static std::bitset<sf::Keyboard::KeyCount> mKeysDown;
+
+	/**
+	 * @brief Keys released since the last update().
+	 *
+	 */
+	static std::bitset<sf::Keyboard::KeyCount> mKeysPendingRelease;
+
+	/**
+	 * @brief Keys released during the current frame.
 	 *
 	 */
-	static std::unordered_map<sf::Keyboard::Key, short> mKeyStates;
+	static std::bitset<sf::Keyboard::KeyCount> mKeysReleased;
 
 	/**
-	 * @brief The current LMB state.
+	 * @brief Mouse buttons currently held down, indexed by button.
 	 *
 	 */
-	static short mLMouseState;
+	static std::bitset<sf::Mouse::ButtonCount> mButtonsDown;
 
 	/**
-	 * @brief The current RMB state.
+	 * @brief Mouse buttons released since the last update().
 	 *
 	 */
-	static short mRMouseState;
+	static std::bitset<sf::Mouse::ButtonCount> mButtonsPendingRelease;
+
+	/**
+	 * @brief Mouse buttons released during the current frame.
+	 *
+	 */
+	static std::bitset<sf::Mouse::ButtonCount> mButtonsReleased;
+
+	/**
+	 * @brief The latest mouse position reported by events.
+	 *
+	 */
+	static sf::Vector2i mPendingMousePos;
+
+	/**
+	 * @brief The mouse position, as of the last update().
+	 *
+	 */
+	static sf::Vector2i mMousePos;
+
+	/**
+	 * @brief The view the map is drawn with.
+	 *
+	 */
+	static const sf::View *mMapView;
+
+	/**
+	 * @brief The mouse position in map coordinates, as of the last update().
+	 *
+	 */
+	static sf::Vector2f mMapMousePos;
+
+	/**
+	 * @brief Retrieve the state of a mouse button.
+	 *
+	 * @see getKeyState
+	 */
+	static short getButtonState(sf::Mouse::Button button);
 };
\ No newline at end of file
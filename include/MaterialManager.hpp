@@ -1,22 +1,32 @@
 #pragma once
 
 #include <algorithm>
-#include <map>
+#include <functional>
 #include <queue>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 #include <SFML/Graphics.hpp>
 
 #include "nlohmann/json.hpp"
 
-/////////////TODO/////////////
-// Multiple unordered maps,all sorted by the same type of key.
-// Can/Will be refactored into one map.
-//////////////////////////////
+#include "BigNumber.hpp"
+#include "TextureAtlas.hpp"
 
 /**
  * @brief Standalone class to init, and track in-game resources.
  *
+ * @remarks Resources are identified by a ResourceID, their index in the
+ * "resources" array of object_data.json. Name-based functions are kept for
+ * convenience, but hot paths should resolve IDs once & use those.
+ *
+ * @remarks Changes to counts are batched, and reported to change listeners
+ * once per flushChanges().
+ *
+ * @remarks Registered purchasables keep a cached affordable flag, which is
+ * only rechecked on flush for those using a changed resource.
+ *
  */
 class MaterialManager
 {
@@ -27,6 +37,12 @@ public:
 	 */
 	MaterialManager();
 
+	/**
+	 * @brief Index of a resource, in the order they were loaded.
+	 *
+	 */
+	typedef unsigned ResourceID;
+
 	/**
 	 * @brief Struct to bind a resource with a count.
 	 *
@@ -34,15 +50,69 @@ public:
 	struct Resource
 	{
 		std::string name;
-		long count;
+		BigNumber count;
 	};
 
+	/**
+	 * @brief Struct to bind a resource ID with a count.
+	 *
+	 */
+	struct ResourceAmount
+	{
+		ResourceID id;
+		BigNumber count;
+	};
+
+	/**
+	 * @brief A pre-resolved price, per-tick cost, or any other list of
+	 * resource amounts.
+	 *
+	 */
+	typedef std::vector<ResourceAmount> Cost;
+
+	/**
+	 * @brief Called with a resource's count at the previous flush & its
+	 * current count.
+	 *
+	 */
+	typedef std::function<void(ResourceID, const BigNumber &, const BigNumber &)>
+		ChangeListener;
+
+	/**
+	 * @brief Index of a registered purchasable, in the order they were added.
+	 *
+	 */
+	typedef unsigned PurchasableID;
+
 	/**
 	 * @brief Initialize the names of all resources.
 	 *
 	 * @param resources The json object for resource/objects/object_data.json
+	 * @param atlas The atlas containing the resource icons.
+	 */
+	void initResources(nlohmann::json &resources, const TextureAtlas &atlas);
+
+	/**
+	 * @brief Get the ID of the given resource.
+	 *
+	 * @param resource_name The name of the resource.
+	 * @return ResourceID Its ID.
+	 *
+	 * @throws std::out_of_range If the resource doesn't exist.
+	 */
+	ResourceID getResourceID(const std::string &resource_name) const;
+
+	/**
+	 * @brief Get the name of the given resource.
+	 *
 	 */
-	void initResources(nlohmann::json &resources);
+	const std::string &getResourceName(ResourceID id) const;
+
+	/**
+	 * @brief Get the number of resource types.
+	 *
+	 */
+	unsigned getResourceTypeCount() const;
 
 	/**
 	 * @brief Set a specific resource to a specific amount.
@@ -55,9 +125,17 @@ public:
 	 * @brief Get the count of a specific resource.
 	 *
 	 * @param resource_name The name of the resource.
-	 * @return int The amount in possession.
+	 * @return BigNumber The amount in possession.
+	 */
+	BigNumber getResourceCount(std::string resource_name);
+
+	/**
+	 * @brief Get the count of a specific resource.
+	 *
+	 * @param id The ID of the resource.
+	 * @return const BigNumber& The amount in possession.
 	 */
-	int getResourceCount(std::string resource_name);
+	const BigNumber &getResourceCount(ResourceID id) const;
 
 	/**
 	 * @brief Add an amount to a specific resource.
@@ -67,6 +145,13 @@ public:
 	 */
 	void addResources(Resource r);
 
+	/**
+	 * @brief Add every amount in the given list.
+	 *
+	 * @param c The resources to add.
+	 */
+	void addResources(const Cost &c);
+
 	/**
 	 * @brief Remove an amount from a specific resource.
 	 *
@@ -76,12 +161,14 @@ public:
 	void removeResources(Resource r);
 
 	/**
-	 * @brief Convert a json array to a vector of resource objects.
-	 * 
+	 * @brief Convert a json array to a pre-resolved cost.
+	 *
 	 * @param price A JSON array, formatted as a standard purchase cost.
-	 * @return std::vector<Resource> A vector of the required resources.
+	 * @return Cost The required resources.
+	 *
+	 * @throws std::out_of_range If a resource doesn't exist.
 	 */
-	std::vector<Resource> priceToResourceVector(nlohmann::json::array_t price);
+	Cost priceToCost(const nlohmann::json &price) const;
 
 	/**
 	 * @brief Checks if there are as many resources in storage as given.
@@ -93,12 +180,12 @@ public:
 
 	/**
 	 * @brief Checks if all the given resources are in storage.
-	 * 
-	 * @param r The resources to check.
+	 *
+	 * @param c The resources to check.
 	 * @return true If all the resources exist.
 	 * @return false If the item is unpurchaseable.
 	 */
-	bool canPurchaseMultiple(std::vector<Resource> r);
+	bool canPurchase(const Cost &c) const;
 
 	/**
 	 * @brief Attempt to purchase an object from the resources required..
@@ -111,12 +198,49 @@ public:
 
 	/**
 	 * @brief Attempt to purchase an item of multiple resource costs.
-	 * 
-	 * @param r The resources to deduct from.
+	 *
+	 * @param c The resources to deduct from.
 	 * @return true If the item was successfully purchased.
 	 * @return false If there weren't enough resources to purchase the item.
 	 */
-	bool purchaseMultiple(std::vector<Resource> r);
+	bool purchase(const Cost &c);
+
+	/**
+	 * @brief Register a cost to track the affordability of.
+	 *
+	 * @param c The cost.
+	 * @return PurchasableID The ID to query it with.
+	 */
+	PurchasableID addPurchasable(const Cost &c);
+
+	/**
+	 * @brief Replace the cost of a registered purchasable, & recheck it.
+	 *
+	 * @remarks Call whenever the price changes.
+	 */
+	void setPurchasableCost(PurchasableID id, const Cost &c);
+
+	/**
+	 * @brief Check if a registered purchasable was affordable at the last
+	 * flush, or cost change.
+	 *
+	 */
+	bool isAffordable(PurchasableID id) const;
+
+	/**
+	 * @brief Register a function to be called for every resource whose count
+	 * changed between flushes.
+	 *
+	 */
+	void addChangeListener(ChangeListener listener);
+
+	/**
+	 * @brief Report every resource changed since the last flush to the
+	 * change listeners.
+	 *
+	 * @remarks Call once per frame, after all updates.
+	 */
+	void flushChanges();
 
 	/**
 	 * @brief Updates tick-by-tick resource statistics, such as average
@@ -130,39 +254,106 @@ public:
 	/**
 	 * @brief Get the average resource gain/loss per tick.
 	 *
-	 * @param resource The resource to retrieve.
+	 * @param id The resource to retrieve.
 	 * @return float The amount gained/lost per tick.
 	 */
-	float getAverageResourcePerTick(std::string resource);
+	float getAverageResourcePerTick(ResourceID id);
 
 	/**
-	 * @brief Retrieve a const reference to the resource map.
+	 * @brief Get the icon sprite for the specified resource.
 	 *
-	 * @return const std::unordered_map<std::string, int>& A reference to the
-	 * internal resources.
+	 * @param resource The resource's icon to retrieve.
+	 * @return const sf::Sprite& The icon, from the texture atlas.
 	 */
-	const std::map<std::string, long> &getResources();
+	const sf::Sprite &getIcon(std::string resource);
 
 	/**
-	 * @brief Get a pointer to the icon texture for the specified resource.
+	 * @brief Get the icon sprite for the specified resource.
 	 *
-	 * @param resource The resource's texture to retrieve.
-	 * @return sf::Texture* A pointer to the texture.
+	 * @param id The resource's ID.
+	 * @return const sf::Sprite& The icon, from the texture atlas.
 	 */
-	sf::Texture *getTexture(std::string resource);
+	const sf::Sprite &getIcon(ResourceID id);
 
 private:
 	/**
-	 * @brief Internal map of the name to the count of each resource.
+	 * @brief Names of every resource, indexed by ID.
+	 *
+	 */
+	std::vector<std::string> mNames;
+
+	/**
+	 * @brief Map of resource names to their ID.
+	 *
+	 */
+	std::unordered_map<std::string, ResourceID> mIDs;
+
+	/**
+	 * @brief The count of each resource, indexed by ID.
+	 *
+	 */
+	std::vector<BigNumber> mCounts;
+
+	/**
+	 * @brief The count of each resource at the last flushChanges().
+	 *
+	 */
+	std::vector<BigNumber> mFlushedCounts;
+
+	/**
+	 * @brief Resources modified since the last flush, without duplicates.
+	 *
+	 */
+	std::vector<ResourceID> mChanged;
+
+	/**
+	 * @brief True for every resource in mChanged, indexed by ID.
+	 *
+	 */
+	std::vector<bool> mIsChanged;
+
+	/**
+	 * @brief Functions called by flushChanges().
+	 *
+	 */
+	std::vector<ChangeListener> mChangeListeners;
+
+	/**
+	 * @brief Flag a resource as changed since the last flush.
+	 *
+	 */
+	void markChanged(ResourceID id);
+
+	/**
+	 * @brief The cost of each purchasable, indexed by PurchasableID.
+	 *
+	 */
+	std::vector<Cost> mPurchasableCosts;
+
+	/**
+	 * @brief Whether each purchasable is affordable, indexed by PurchasableID.
+	 *
+	 */
+	std::vector<bool> mAffordable;
+
+	/**
+	 * @brief The purchasables whose cost uses each resource, indexed by ID.
+	 *
+	 */
+	std::vector<std::vector<PurchasableID>> mPurchasablesByResource;
+
+	/**
+	 * @brief Add or remove a purchasable from the lists of the resources its
+	 * cost uses.
 	 *
 	 */
-	std::map<std::string, long> mResources;
+	void indexPurchasable(PurchasableID id, bool add);
 
 	/**
-	 * @brief Map of resources to their texture.
+	 * @brief Icon sprites of each resource, indexed by ID.
 	 *
 	 */
-	std::unordered_map<std::string, sf::Texture> mIconTextures;
+	std::vector<sf::Sprite> mIcons;
 
 	/**
 	 * @brief How many values back to log.
@@ -176,8 +367,8 @@ private:
 
 	/**
 	 * @brief Logs resources for their previous values, to measure average
-	 * change/tick.
+	 * change/tick. Indexed by ID.
 	 *
 	 */
-	std::unordered_map<std::string, std::deque<float>> mResourceLog;
-};
\ No newline at end of file
+	std::vector<std::deque<BigNumber>> mResourceLog;
+};
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief A one pixel per tile overview of the map & its buildings.
+ *
+ * @remarks The map & buildings are read through sources rather than copied.
+ * Tiles are marked as they change, & update() recolors them from the sources
+ * before uploading the dirty area of each chunk, one texture update apiece.
+ * Drawn scaled to the tile size, it doubles as the zoomed-out render path.
+ *
+ */
+class Minimap : public sf::Drawable, public sf::Transformable
+{
+public:
+	/**
+	 * @brief Default constructor. Call init() before use.
+	 *
+	 */
+	Minimap();
+
+	/**
+	 * @brief Size the minimap, & set the colors of tiles & buildings.
+	 *
+	 * @param grid The size of the map, in tiles.
+	 * @param ground_colors The color of each tile ID, including air as 0.
+	 * @param building_colors The color of each building ID.
+	 */
+	void init(sf::Vector2i grid,
+			  std::vector<sf::Color> ground_colors,
+			  std::vector<sf::Color> building_colors);
+
+	/**
+	 * @brief Reads an ID off a tile, by its index in the grid.
+	 *
+	 */
+	typedef std::function<int(unsigned)> Source;
+
+	/**
+	 * @brief Set where the ground tile IDs are read from, & recolor every
+	 * tile on the next update().
+	 *
+	 */
+	void setGroundSource(Source ground);
+
+	/**
+	 * @brief Set where the building IDs are read from, -1 for none, & recolor
+	 * every tile on the next update().
+	 *
+	 */
+	void setBuildingSource(Source buildings);
+
+	/**
+	 * @brief Recolor a tile on the next update().
+	 *
+	 * @param tile The tile's index in the grid.
+	 */
+	void markChanged(unsigned tile);
+
+	/**
+	 * @brief Recolor the changed tiles, & upload their pixels to the texture.
+	 * Call once per frame.
+	 *
+	 * @return true If anything changed.
+	 */
+	bool update();
+
+	/**
+	 * @brief Get the minimap texture, one pixel per tile.
+	 *
+	 */
+	const sf::Texture &getTexture() const;
+
+private:
+	/**
+	 * @brief SFML's draw() override.
+	 *
+	 */
+	virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
+
+	/**
+	 * @brief Recolor a tile's pixel from the sources.
+	 *
+	 */
+	void updatePixel(unsigned tile);
+
+	/**
+	 * @brief Grow the dirty area of a tile's chunk to contain it.
+	 *
+	 */
+	void markDirty(unsigned tile);
+
+	/**
+	 * @brief The width & height of a chunk, in tiles.
+	 *
+	 */
+	static const int CHUNK_SIZE = 32;
+
+	sf::Vector2i mGrid;
+	std::vector<sf::Color> mGroundColors;
+	std::vector<sf::Color> mBuildingColors;
+	Source mGround;
+	Source mBuildings;
+
+	/**
+	 * @brief The tiles marked since the last update(), maybe repeated.
+	 *
+	 */
+	std::vector<unsigned> mChangedTiles;
+
+	/**
+	 * @brief True if every tile should be recolored.
+	 *
+	 */
+	bool mAllChanged;
+
+	/**
+	 * @brief The RGBA pixels, one per tile.
+	 *
+	 */
+	std::vector<sf::Uint8> mPixels;
+
+	/**
+	 * @brief The area of each chunk changed since the last update(), empty if
+	 * none.
+	 *
+	 * @remarks Chunks are indexed row-major.
+	 */
+	sf::Vector2i mChunkCount;
+	std::vector<sf::IntRect> mDirtyRects;
+
+	/**
+	 * @brief The chunks with a dirty area, without duplicates.
+	 *
+	 */
+	std::vector<unsigned> mDirtyChunks;
+
+	/**
+	 * @brief The pixels of a dirty area, packed for uploading.
+	 *
+	 */
+	std::vector<sf::Uint8> mUpload;
+
+	sf::Texture mTexture;
+	sf::Sprite mSprite;
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "BigNumber.hpp"
+#include "Fixed.hpp"
+#include "MaterialManager.hpp"
+
+/**
+ * @brief The ways a modifier can act on a stat.
+ *
+ */
+enum class ModifierType
+{
+	Add,
+	Multiply,
+	Divide,
+	Override
+};
+
+/**
+ * @brief A single entry in a stat's modifier stack.
+ *
+ */
+struct Modifier
+{
+	ModifierType type;
+	Fixed value;
+	/// Who applied the modifier (ex: the upgrade index), for removal.
+	unsigned source;
+	/// How many times the modifier is stacked in a row.
+	unsigned count;
+	/// The tick the modifier expires on, 0 is never.
+	unsigned long long expires;
+};
+
+/**
+ * @brief Applies a modifier to a count.
+ *
+ * @remarks A multiplier or divisor stacked n times is applied a step at a
+ * time, rounding after each, so the count is exactly what n separate
+ * purchases would give. It stops early once the count saturates or a step
+ * no longer changes it.
+ */
+void applyModifier(BigNumber &value, const Modifier &mod);
+
+/**
+ * @brief Applies a modifier to a rate, stacking like the count overload.
+ *
+ */
+void applyModifier(Fixed &value, const Modifier &mod);
+
+/**
+ * @brief An immutable base value, an ordered stack of modifiers, and the
+ * cached result of applying them.
+ *
+ * @remarks The result is only recomputed after the stack changes.
+ *
+ */
+template <typename T>
+class ModifiedStat
+{
+public:
+	/**
+	 * @brief Construct with the given base value.
+	 *
+	 */
+	ModifiedStat(T base = T())
+		: mBase(base), mCached(base), mDirty(false)
+	{
+	}
+
+	/**
+	 * @brief Get the value with every modifier applied.
+	 *
+	 */
+	const T &get() const
+	{
+		if (mDirty)
+		{
+			mCached = mBase;
+			for (auto &i : mModifiers)
+			{
+				applyModifier(mCached, i);
+			}
+			mDirty = false;
+		}
+		return mCached;
+	}
+
+	/**
+	 * @brief Get the unmodified value.
+	 *
+	 */
+	const T &getBase() const
+	{
+		return mBase;
+	}
+
+	/**
+	 * @brief Get the modifier stack, in application order.
+	 *
+	 */
+	const std::vector<Modifier> &getModifiers() const
+	{
+		return mModifiers;
+	}
+
+	/**
+	 * @brief Push a modifier to the top of the stack. Merged into the top
+	 * modifier if it's otherwise identical.
+	 *
+	 */
+	void push(const Modifier &mod)
+	{
+		if (mod.count == 0)
+		{
+			return;
+		}
+
+		if (!mModifiers.empty())
+		{
+			Modifier &top = mModifiers.back();
+			if (top.type == mod.type && top.value == mod.value &&
+				top.source == mod.source && top.expires == mod.expires)
+			{
+				top.count += mod.count;
+				mDirty = true;
+				return;
+			}
+		}
+
+		mModifiers.push_back(mod);
+		mDirty = true;
+	}
+
+	/**
+	 * @brief Remove every modifier applied by the given source.
+	 *
+	 * @return true If anything was removed.
+	 */
+	bool removeSource(unsigned source)
+	{
+		return removeIf([&](const Modifier &m) { return m.source == source; });
+	}
+
+	/**
+	 * @brief Remove every modifier that expires on or before the given tick.
+	 *
+	 * @return true If anything was removed.
+	 */
+	bool expire(unsigned long long tick)
+	{
+		return removeIf([&](const Modifier &m) {
+			return m.expires != 0 && m.expires <= tick;
+		});
+	}
+
+	/**
+	 * @brief The earliest tick a modifier expires on, 0 if none do.
+	 *
+	 */
+	unsigned long long getNextExpiry() const
+	{
+		unsigned long long ret = 0;
+		for (auto &i : mModifiers)
+		{
+			if (i.expires != 0 && (ret == 0 || i.expires < ret))
+			{
+				ret = i.expires;
+			}
+		}
+		return ret;
+	}
+
+private:
+	/**
+	 * @brief Removes all modifiers matching the predicate.
+	 *
+	 */
+	template <typename Pred>
+	bool removeIf(Pred pred)
+	{
+		auto end = std::remove_if(mModifiers.begin(), mModifiers.end(), pred);
+		if (end == mModifiers.end())
+		{
+			return false;
+		}
+		mModifiers.erase(end, mModifiers.end());
+		mDirty = true;
+		return true;
+	}
+
+	/**
+	 * @brief The unmodified value.
+	 *
+	 */
+	T mBase;
+
+	/**
+	 * @brief The ordered modifier stack.
+	 *
+	 */
+	std::vector<Modifier> mModifiers;
+
+	/**
+	 * @brief The last computed value.
+	 *
+	 */
+	mutable T mCached;
+
+	/**
+	 * @brief True if mCached needs recomputing.
+	 *
+	 */
+	mutable bool mDirty;
+};
+
+/**
+ * @brief A cost list where every slot is a ModifiedStat, with the resulting
+ * cost cached for the tick & GUI to read.
+ *
+ */
+class ModifiedCost
+{
+public:
+	/**
+	 * @brief Default constructor, an empty cost.
+	 *
+	 */
+	ModifiedCost();
+
+	/**
+	 * @brief Construct from the base cost.
+	 *
+	 */
+	ModifiedCost(const MaterialManager::Cost &base);
+
+	/**
+	 * @brief Get the cost with every modifier applied.
+	 *
+	 * @remarks Only recomputed after a modifier changes.
+	 */
+	const MaterialManager::Cost &get() const;
+
+	/**
+	 * @brief Get the unmodified cost.
+	 *
+	 */
+	const MaterialManager::Cost &getBase() const;
+
+	/**
+	 * @brief Get the stat of a single slot, for inspection.
+	 *
+	 */
+	const ModifiedStat<BigNumber> &getSlot(unsigned slot) const;
+
+	/**
+	 * @brief Push a modifier onto a single slot.
+	 *
+	 */
+	void push(unsigned slot, const Modifier &mod);
+
+	/**
+	 * @brief Remove every modifier applied by the given source.
+	 *
+	 * @return true If anything was removed.
+	 */
+	bool removeSource(unsigned source);
+
+	/**
+	 * @brief Remove every modifier that expires on or before the given tick.
+	 *
+	 * @return true If anything was removed.
+	 */
+	bool expire(unsigned long long tick);
+
+	/**
+	 * @brief The earliest tick a modifier expires on, 0 if none do.
+	 *
+	 */
+	unsigned long long getNextExpiry() const;
+
+private:
+	/**
+	 * @brief The unmodified cost.
+	 *
+	 */
+	MaterialManager::Cost mBase;
+
+	/**
+	 * @brief The stat of each slot.
+	 *
+	 */
+	std::vector<ModifiedStat<BigNumber>> mSlots;
+
+	/**
+	 * @brief The last computed cost.
+	 *
+	 */
+	mutable MaterialManager::Cost mCached;
+
+	/**
+	 * @brief True if mCached needs recomputing.
+	 *
+	 */
+	mutable bool mDirty;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Packs every image in a set of directories into a single texture, so
+ * sprites & ImGui images can share one texture & batch together.
+ *
+ * @remarks Images are looked up by the path they would've been loaded from,
+ * e.g. "resource/objects/textures/icons/cash.png".
+ *
+ */
+class TextureAtlas
+{
+public:
+	/**
+	 * @brief Load & pack every .png under the given directories, recursively.
+	 *
+	 * @param directories The directories to pack.
+	 *
+	 * @throws std::runtime_error If an image fails to load, or the images
+	 * don't fit in the largest supported texture.
+	 */
+	TextureAtlas(std::vector<std::string> directories);
+
+	/**
+	 * @brief Get the packed texture.
+	 *
+	 */
+	const sf::Texture &getTexture() const;
+
+	/**
+	 * @brief Get the area of the texture an image was packed into.
+	 *
+	 * @param path The path of the image.
+	 * @return sf::IntRect The image's area.
+	 *
+	 * @throws std::out_of_range If the image wasn't packed.
+	 */
+	sf::IntRect getRect(const std::string &path) const;
+
+	/**
+	 * @brief Get a sprite of a packed image.
+	 *
+	 * @param path The path of the image.
+	 *
+	 * @throws std::out_of_range If the image wasn't packed.
+	 */
+	sf::Sprite getSprite(const std::string &path) const;
+
+	/**
+	 * @brief Get the average color of the opaque pixels in an area.
+	 *
+	 * @param rect The area of the atlas.
+	 */
+	sf::Color getAverageColor(const sf::IntRect &rect) const;
+
+private:
+	/**
+	 * @brief Empty pixels between images, to stop neighbours bleeding in.
+	 *
+	 */
+	const unsigned PADDING = 1;
+
+	/**
+	 * @brief The packed texture.
+	 *
+	 */
+	sf::Texture mTexture;
+
+	/**
+	 * @brief A CPU-side copy of the packed texture.
+	 *
+	 */
+	sf::Image mImage;
+
+	/**
+	 * @brief Map of normalized image paths to their packed areas.
+	 *
+	 */
+	std::unordered_map<std::string, sf::IntRect> mRects;
+
+	/**
+	 * @brief Normalizes a path, so equivalent paths share a key.
+	 *
+	 */
+	static std::string normalize(const std::string &path);
+};
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+
+#include "GridLayout.hpp"
+#include "TileEditBatch.hpp"
+#include "Tilemap.hpp"
+
+/**
+ * @brief Grows tiles into each other over time, ex: trees spreading into
+ * neighbouring grass, by stepping a cellular automaton over the map.
+ *
+ * @remarks The rules & step rate are read from the "growth" object of the
+ * map's json. See resource/maps/INFO.md.
+ *
+ * @remarks Each step reads the front grid & writes the back one, chunk by
+ * chunk, across a pool of worker threads, one per core, woken for each step
+ * while the main thread carries on. Chunks where no rule can fire are
+ * skipped: a chunk stays active only while it holds a tile some rule changes,
+ * & for rules needing neighbours, a neighbour type within one tile of it.
+ * Once a step finishes, the grids are swapped & the changed tiles applied to
+ * the map in one batch, so only their chunks are re-rendered.
+ *
+ * @remarks Map edits made during a step are queued, & win over whatever the
+ * step computed for the same tile.
+ */
+class TileAutomaton
+{
+public:
+	/**
+	 * @brief Default constructor. Call init() before use.
+	 *
+	 */
+	TileAutomaton();
+
+	/**
+	 * @brief Stops & joins the workers, abandoning any running step.
+	 *
+	 */
+	~TileAutomaton();
+
+	/**
+	 * @brief Read the map's rules, copy its tiles, follow its edits & start
+	 * the workers.
+	 *
+	 * @remarks Maps without a "growth" object never change, & start none.
+	 *
+	 * @throws std::runtime_error If a rule names an unknown tile, the rate
+	 * isn't positive, or there are too many tile types to store in a byte.
+	 */
+	void init(Tilemap *map);
+
+	/**
+	 * @brief Apply a finished step to the map, & start the next when due.
+	 *
+	 * @return true If any tiles changed.
+	 */
+	bool update();
+
+	/**
+	 * @brief The time left before update() has work to do: the next step,
+	 * or a check on the running one.
+	 *
+	 */
+	sf::Time getTimeUntilStep() const;
+
+private:
+	/**
+	 * @brief A tile turning into another, by chance, depending on its
+	 * 8 neighbours.
+	 *
+	 */
+	struct Rule
+	{
+		uint8_t from;
+		uint8_t to;
+		/// The neighbour type counted, or BORDER to ignore neighbours.
+		uint8_t near;
+		/// True if the rule can't fire without a neighbour of type near.
+		bool needs_near;
+		/// The range of neighbours of type near needed, inclusive.
+		int min;
+		int max;
+		/// The chance per step out of 2^32, compared against a hash.
+		uint32_t threshold;
+	};
+
+	/**
+	 * @brief The value of the padding around the grids, matching no tile.
+	 *
+	 */
+	static const uint8_t BORDER = 0xFF;
+
+	/**
+	 * @brief The width & height of a chunk, in tiles. Matches the Tilemap's
+	 * chunks, so a changed chunk re-renders one of the map's layers.
+	 *
+	 */
+	static const int CHUNK_SIZE = GridLayout::CHUNK_SIZE;
+
+	/**
+	 * @brief How often a running step is checked on.
+	 *
+	 */
+	const sf::Time STEP_POLL_TIME = sf::milliseconds(1);
+
+	///////////////SETTINGS///////////////
+	Tilemap *mMap;
+	std::vector<Rule> mRules;
+	sf::Time mInterval;
+	sf::Vector2i mSize;
+	sf::Vector2i mChunkCount;
+
+	/**
+	 * @brief The row length of the padded grids.
+	 *
+	 */
+	int mStride;
+
+	///////////////MAIN THREAD///////////////
+	sf::Clock mClock;
+
+	/**
+	 * @brief The number of steps taken, which seeds each step's chances.
+	 *
+	 */
+	uint32_t mStep;
+
+	/**
+	 * @brief Map edits made during a step, applied once it's finished.
+	 *
+	 */
+	std::vector<std::pair<unsigned, uint8_t>> mPending;
+
+	/**
+	 * @brief True while the workers are stepping.
+	 *
+	 */
+	bool mStepping;
+
+	/**
+	 * @brief The worker pool, started by init().
+	 *
+	 */
+	std::vector<std::thread> mWorkers;
+
+	///////////////SHARED, GUARDED BY mMutex///////////////
+	std::mutex mMutex;
+	std::condition_variable mWake;
+	bool mStop;
+
+	/**
+	 * @brief Counts the steps started, so each wakes the workers once.
+	 *
+	 */
+	unsigned mGeneration;
+
+	///////////////SHARED DURING A STEP///////////////
+
+	/**
+	 * @brief The tile IDs, with a border of 1 tile all around, so
+	 * neighbours can be read without bounds checks.
+	 *
+	 * @remarks Workers only read mFront, & each writes only its own chunks
+	 * of mBack & the per-chunk flags.
+	 */
+	std::vector<uint8_t> mFront;
+	std::vector<uint8_t> mBack;
+
+	/**
+	 * @brief 1 for chunks where some rule may fire.
+	 *
+	 * @remarks Chars rather than bools, so workers can write different
+	 * chunks at once.
+	 */
+	std::vector<char> mActive;
+
+	/**
+	 * @brief 1 for chunks that changed last step, so whose back buffer is
+	 * behind.
+	 *
+	 */
+	std::vector<char> mChunkChanged;
+
+	/**
+	 * @brief The tiles each worker changed, by row-major index.
+	 *
+	 */
+	std::vector<std::vector<unsigned>> mChanged;
+
+	/**
+	 * @brief The next chunk for a worker to take.
+	 *
+	 */
+	std::atomic<unsigned> mNextChunk;
+
+	/**
+	 * @brief The number of workers still stepping.
+	 *
+	 */
+	std::atomic<unsigned> mRunning;
+
+	/**
+	 * @brief Wake the workers to step every chunk.
+	 *
+	 */
+	void startStep();
+
+	/**
+	 * @brief Swap the grids, & apply the step's changes to the map.
+	 *
+	 * @return true If any tiles changed.
+	 */
+	bool finishStep();
+
+	/**
+	 * @brief Set a tile in both grids.
+	 *
+	 */
+	void setTile(unsigned tile, uint8_t id);
+
+	/**
+	 * @brief Activate every chunk within one tile of a changed tile, as
+	 * rules there may fire now.
+	 *
+	 */
+	void activateAround(unsigned tile);
+
+	/**
+	 * @brief A worker's loop: wait for a step, then step chunks until there
+	 * are none left.
+	 *
+	 * @param changed Where to put the indices of the changed tiles.
+	 */
+	void work(std::vector<unsigned> &changed);
+
+	/**
+	 * @brief Whether any rule may fire in a chunk next step.
+	 *
+	 * @remarks Reads the chunk's new tiles in mBack, & the ring of tiles
+	 * around it in mFront, as other workers may be writing theirs to mBack.
+	 * Changes to the ring are caught by activateAround() once the step ends.
+	 */
+	bool isActive(int left, int top, int width, int bottom) const;
+
+	/**
+	 * @brief Step a single chunk into the back grid.
+	 *
+	 */
+	void stepChunk(unsigned chunk, std::vector<unsigned> &changed);
+
+	/**
+	 * @brief Apply a rule to a row of a chunk.
+	 *
+	 * @remarks Branch-free over the row, so it can be vectorized. Its file
+	 * is built at -O3 for this, see CMakeLists.txt.
+	 *
+	 * @param up, mid, down The row & the rows either side, in mFront.
+	 * @param out The row in mBack.
+	 * @param width The number of tiles in the row.
+	 * @param seed The row's hash seed, for this rule & step.
+	 * @param left The x of the row's first tile.
+	 */
+	void applyRule(const Rule &rule,
+				   const uint8_t *up,
+				   const uint8_t *mid,
+				   const uint8_t *down,
+				   uint8_t *out,
+				   int width,
+				   uint32_t seed,
+				   int left) const;
+
+	/**
+	 * @brief Scramble the bits of a number, for cheap per-tile chances.
+	 *
+	 */
+	static uint32_t mix(uint32_t h)
+	{
+		h ^= h >> 16;
+		h *= 0x7FEB352Du;
+		h ^= h >> 15;
+		h *= 0x846CA68Bu;
+		h ^= h >> 16;
+		return h;
+	}
+
+	/**
+	 * @brief The index of a tile in the padded grids.
+	 *
+	 */
+	unsigned padded(int x, int y) const
+	{
+		return (y + 1) * mStride + (x + 1);
+	}
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <vector>
+
+/**
+ * @brief A list of tile edits, applied to a Tilemap all at once.
+ *
+ * @remarks Edits are applied in the order they were made, so a later edit of
+ * the same tile wins. Nothing is checked until the batch is applied;
+ * off-map edits are skipped then.
+ *
+ * @see Tilemap::applyEdits()
+ */
+class TileEditBatch
+{
+public:
+	/**
+	 * @brief A single tile edit.
+	 *
+	 */
+	struct Edit
+	{
+		sf::Vector2i pos;
+		int id;
+	};
+
+	/**
+	 * @brief Default constructor, of an empty batch.
+	 *
+	 */
+	TileEditBatch();
+
+	/**
+	 * @brief Set a tile's ID.
+	 *
+	 * @param pos The tile's position, in tiles.
+	 * @param id The new tile ID.
+	 */
+	void set(sf::Vector2i pos, int id);
+
+	/**
+	 * @brief Set every tile in a rectangle to an ID.
+	 *
+	 * @param rect The rectangle, in tiles.
+	 * @param id The new tile ID.
+	 */
+	void fill(sf::IntRect rect, int id);
+
+	/**
+	 * @brief Get every edit, in order.
+	 *
+	 */
+	const std::vector<Edit> &getEdits() const;
+
+	/**
+	 * @brief Check if the batch has no edits.
+	 *
+	 */
+	bool empty() const;
+
+	/**
+	 * @brief Remove every edit, for reuse.
+	 *
+	 */
+	void clear();
+
+private:
+	/**
+	 * @brief The edits, in order.
+	 *
+	 */
+	std::vector<Edit> mEdits;
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "GridLayout.hpp"
+
+/**
+ * @brief A grid of tile IDs, stored in palette-compressed chunks.
+ *
+ * @remarks Each chunk keeps a palette of the distinct IDs it contains, and
+ * stores every tile as a bit-packed index into that palette. Indices are 1, 2,
+ * 4, 8 or 16 bits wide, so they never straddle a 64-bit word. A chunk is
+ * promoted to the next width when a write adds more IDs than fit.
+ *
+ * @remarks Palette entries are reference counted, so an ID that's been
+ * overwritten everywhere in a chunk frees its slot for the next new ID.
+ *
+ * @remarks Chunks & the tiles within them follow a GridLayout. Use forRow(),
+ * forRect() & forRadius() for neighbourhood scans, which call
+ * f(sf::Vector2i pos, int id).
+ *
+ */
+class TileStorage
+{
+public:
+	/**
+	 * @brief Default constructor, of an empty grid.
+	 *
+	 */
+	TileStorage();
+
+	/**
+	 * @brief Resize the grid, & fill it with a single ID.
+	 *
+	 * @param size The new size, in tiles.
+	 * @param fill The ID every tile starts as.
+	 */
+	void resize(sf::Vector2i size, int fill = 0);
+
+	/**
+	 * @brief Resize the grid, & fill it from a row-major array of IDs.
+	 *
+	 * @param size The new size, in tiles.
+	 * @param tiles size.x * size.y IDs.
+	 *
+	 * @throws std::invalid_argument If tiles is the wrong length.
+	 */
+	void assign(sf::Vector2i size, const std::vector<int> &tiles);
+
+	/**
+	 * @brief Get the ID of a tile.
+	 *
+	 * @param x The tile's column.
+	 * @param y The tile's row.
+	 */
+	int get(int x, int y) const;
+
+	/**
+	 * @brief Get the ID of a tile.
+	 *
+	 * @param index The tile's row-major index in the grid.
+	 */
+	int get(unsigned index) const;
+
+	/**
+	 * @brief Set the ID of a tile, promoting its chunk if needed.
+	 *
+	 * @param x The tile's column.
+	 * @param y The tile's row.
+	 * @param id The new ID.
+	 */
+	void set(int x, int y, int id);
+
+	/**
+	 * @brief Set the ID of a tile, promoting its chunk if needed.
+	 *
+	 * @param index The tile's row-major index in the grid.
+	 * @param id The new ID.
+	 */
+	void set(unsigned index, int id);
+
+	/**
+	 * @brief Get the size of the grid, in tiles.
+	 *
+	 */
+	sf::Vector2i getSize() const;
+
+	/**
+	 * @brief Get the number of tiles in the grid.
+	 *
+	 */
+	unsigned size() const;
+
+	/**
+	 * @brief Get the approximate heap memory used by the chunks, in bytes.
+	 *
+	 */
+	std::size_t getMemoryUsage() const;
+
+	/**
+	 * @brief Get the layout of the grid.
+	 *
+	 */
+	const GridLayout &getLayout() const;
+
+	/**
+	 * @brief Visit the tiles of a row, from x to x + width.
+	 *
+	 */
+	template <class F>
+	void forRow(int y, int x, int width, F f) const
+	{
+		forRect(sf::IntRect(x, y, width, 1), f);
+	}
+
+	/**
+	 * @brief Visit every tile in a rectangle, chunk by chunk.
+	 *
+	 */
+	template <class F>
+	void forRect(sf::IntRect rect, F f) const
+	{
+		mLayout.forRect(rect, [&](sf::Vector2i pos, unsigned index) {
+			f(pos, get(index / GridLayout::CHUNK_TILES, index % GridLayout::CHUNK_TILES));
+		});
+	}
+
+	/**
+	 * @brief Visit every tile within radius tiles of another, chunk by chunk.
+	 *
+	 */
+	template <class F>
+	void forRadius(sf::Vector2i center, int radius, F f) const
+	{
+		mLayout.forRadius(center, radius, [&](sf::Vector2i pos, unsigned index) {
+			f(pos, get(index / GridLayout::CHUNK_TILES, index % GridLayout::CHUNK_TILES));
+		});
+	}
+
+private:
+	/**
+	 * @brief A CHUNK_SIZE * CHUNK_SIZE block of tiles.
+	 *
+	 */
+	struct Chunk
+	{
+		/// The distinct IDs in the chunk.
+		std::vector<int> palette;
+		/// How many tiles use each palette entry.
+		std::vector<uint16_t> refs;
+		/// The width of each index, in bits.
+		unsigned bits;
+		/// The packed indices, in GridLayout order.
+		std::vector<uint64_t> data;
+	};
+
+	/**
+	 * @brief Where each tile is stored.
+	 *
+	 */
+	GridLayout mLayout;
+
+	/**
+	 * @brief Every chunk, row-major.
+	 *
+	 */
+	std::vector<Chunk> mChunks;
+
+	/**
+	 * @brief Get the palette index of a tile within its chunk.
+	 *
+	 */
+	static unsigned readIndex(const Chunk &chunk, unsigned tile);
+
+	/**
+	 * @brief Set the palette index of a tile within its chunk.
+	 *
+	 */
+	static void writeIndex(Chunk &chunk, unsigned tile, unsigned index);
+
+	/**
+	 * @brief Repack a chunk's indices at a new width.
+	 *
+	 */
+	static void repack(Chunk &chunk, unsigned bits);
+
+	/**
+	 * @brief Find or add a palette entry for an ID, promoting the chunk if
+	 * the palette outgrows its width.
+	 *
+	 * @return unsigned The entry's index.
+	 */
+	static unsigned findOrAdd(Chunk &chunk, int id);
+
+	/**
+	 * @brief Get the ID of a tile, by its chunk & index within the chunk.
+	 *
+	 */
+	int get(unsigned chunk, unsigned tile) const
+	{
+		const Chunk &c = mChunks[chunk];
+		return c.palette[readIndex(c, tile)];
+	}
+
+	/**
+	 * @brief Get the chunk containing a tile, & the tile's index in it.
+	 *
+	 */
+	std::pair<unsigned, unsigned> locate(int x, int y) const;
+};
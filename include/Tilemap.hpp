@@ -4,6 +4,9 @@
 #include <algorithm>
 #include <cmath>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -11,11 +14,24 @@
 
 #include "nlohmann/json.hpp"
 
-#include "Vector2Hash.inl"
+#include "Minimap.hpp"
+#include "TextureAtlas.hpp"
+#include "TileEditBatch.hpp"
+#include "TileStorage.hpp"
 
 /**
  * @brief Renders a grid of tiles to the screen, using a VertexArray.
  *
+ * @remarks Each chunk in view is rendered once to its own offscreen layer,
+ * which is drawn as a single quad. Chunks are rendered when they come into
+ * view, & again on the next draw after their tiles are edited. Layers of
+ * chunks leaving the view are kept for reuse by the ones entering it.
+ *
+ * @remarks Edits are made in a TileEditBatch, & each applied batch is
+ * published to change listeners as one coalesced TileChange.
+ *
+ * @remarks Tile IDs are kept palette-compressed in a TileStorage.
+ *
  */
 class Tilemap : public sf::Drawable, public sf::Transformable
 {
@@ -23,14 +39,18 @@ public:
 	/**
 	 * @brief Construct the map.
 	 *
+	 * @param atlas The atlas containing the tileset.
 	 */
-	Tilemap();
+	Tilemap(const TextureAtlas *atlas);
 
 	/**
 	 * @brief Construct the map from it's name. Calls loadFromFilename()
 	 * 
+	 * @param atlas The atlas containing the tileset.
+	 *
+	 * @throws std::runtime_error If the map didn't load properly.
 	 */
-	Tilemap(std::string fname);
+	Tilemap(std::string fname, const TextureAtlas *atlas);
 
 	/**
 	 * @brief Loads the tilemap data from it's name.
@@ -58,11 +78,24 @@ public:
 	/**
 	 * @brief Get the Tile ID at the specified position.
 	 *
-	 * @param pos The exact position of the tile.
-	 * @return int The ID.
+	 * @param pos Any position inside the tile.
+	 * @return int The ID, or -1 if the position is off the map.
 	 */
 	int getTileID(sf::Vector2f pos);
 
+	/**
+	 * @brief Get the Tile ID of a tile.
+	 *
+	 * @param tile The tile's row-major index in the grid.
+	 */
+	int getTileIDAt(unsigned tile);
+
+	/**
+	 * @brief Get the number of tile IDs, including air as 0.
+	 *
+	 */
+	int getTileTypeCount();
+
 	/**
 	 * @brief Get a Tile's ID from it's name.
 	 *
@@ -76,9 +109,72 @@ public:
 	 *
 	 * @param pos The tile position to set.
 	 * @param newTileID The new tile ID.
+	 *
+	 * @remarks A batch of one, prefer applyEdits() for many tiles.
 	 */
 	void setTileAt(sf::Vector2f pos, int newTileID);
 
+	/**
+	 * @brief Get how much resource is left in a tile.
+	 *
+	 * @param tile The tile's row-major index in the grid.
+	 * @return unsigned 0 for tiles without a resource.
+	 */
+	unsigned getAmountAt(unsigned tile);
+
+	/**
+	 * @brief Take resource out of a tile.
+	 *
+	 * @remarks When the tile runs out, its conversion is added to the batch,
+	 * so every tile emptied in a tick can be applied at once.
+	 *
+	 * @param tile The tile's row-major index in the grid.
+	 * @param amount The most to take.
+	 * @param conversions The batch to add the conversion to.
+	 * @return unsigned How much was taken.
+	 */
+	unsigned extract(unsigned tile, unsigned amount, TileEditBatch &conversions);
+
+	/**
+	 * @brief Get the map's "growth" object, or null if it has none.
+	 *
+	 * @see TileAutomaton
+	 */
+	const nlohmann::json &getGrowthData();
+
+	/**
+	 * @brief The tiles changed by an applied batch.
+	 *
+	 */
+	struct TileChange
+	{
+		/// The bounding box of every changed tile, in tiles.
+		sf::IntRect region;
+		/// The row-major index of every changed tile, ascending.
+		std::vector<unsigned> tiles;
+	};
+
+	/**
+	 * @brief Called once per applied batch that changed any tiles.
+	 *
+	 */
+	typedef std::function<void(const TileChange &)> ChangeListener;
+
+	/**
+	 * @brief Apply every edit in a batch, then notify the change listeners.
+	 *
+	 * @remarks Costs O(edits) here, plus one render of each dirty chunk in
+	 * view on the next draw. Edits that don't change a tile aren't reported.
+	 */
+	void applyEdits(const TileEditBatch &batch);
+
+	/**
+	 * @brief Register a function to be called with the changes of every
+	 * applied batch.
+	 *
+	 */
+	void addChangeListener(ChangeListener listener);
+
 	/**
 	 * @brief Returns the tile that the point is contained inside of.
 	 *
@@ -94,21 +190,46 @@ public:
 	 */
 	sf::Vector2f getTileSize();
 
+	/**
+	 * @brief Get the dimensions of the map, in tiles.
+	 *
+	 */
+	sf::Vector2i getGridSize();
+
+	/**
+	 * @brief Get the average color of every tile ID, including air as 0.
+	 *
+	 */
+	std::vector<sf::Color> getTileColors();
+
+	/**
+	 * @brief Let a minimap read the tiles, & tell it which ones are set.
+	 *
+	 */
+	void attachMinimap(Minimap *minimap);
+
 	/**
 	 * @brief Return the texture of the tilemap.
 	 *
-	 * @return sf::Texture& A reference to the internal tilemap texture.
+	 * @return const sf::Texture& A reference to the atlas texture.
 	 */
-	sf::Texture &getTileMapTexture();
+	const sf::Texture &getTileMapTexture();
 
 	/**
 	 * @brief Get the position of a tile in the tilemap.
 	 *
 	 * @param tile_name The name of the tile.
-	 * @return sf::FloatRect The area of mMapTexture that the tile resides.
+	 * @return sf::FloatRect The area of the atlas that the tile resides.
 	 */
 	sf::FloatRect getTileTextureRect(std::string tile_name);
 
+	/**
+	 * @brief Get a sprite of a tile's texture.
+	 *
+	 * @param tile_name The name of the tile.
+	 */
+	sf::Sprite getTileSprite(std::string tile_name);
+
 private:
 	/**
 	 * @brief SFML's draw() override.
@@ -117,27 +238,95 @@ private:
 	virtual void draw(sf::RenderTarget &target, sf::RenderStates states) const;
 
 	/**
-	 * @brief The internal vector of vertices.
+	 * @brief The offscreen layer of every chunk, or null.
+	 *
+	 * @remarks Chunks follow mTiles' layout, indexed row-major. Only the
+	 * chunks in mLayerChunks have one.
+	 */
+	mutable std::vector<std::unique_ptr<sf::RenderTexture>> mLayers;
+
+	/**
+	 * @brief The chunks with a layer, which were in view last draw.
+	 *
+	 */
+	mutable std::vector<unsigned> mLayerChunks;
+
+	/**
+	 * @brief Layers of chunks that left the view, to reuse.
+	 *
+	 */
+	mutable std::vector<std::unique_ptr<sf::RenderTexture>> mSpareLayers;
+
+	/**
+	 * @brief True for every chunk whose layer is missing or out of date.
+	 *
+	 */
+	mutable std::vector<bool> mChunkDirty;
+
+	/**
+	 * @brief The quads of the chunk being rendered, kept to reuse its
+	 * memory.
+	 *
+	 */
+	mutable sf::VertexArray mChunkQuads;
+
+	/**
+	 * @brief Flag a tile's chunk for rendering.
+	 *
+	 * @param index The tile's index in mTiles.
+	 */
+	void markDirty(unsigned index);
+
+	/**
+	 * @brief Render a chunk's tiles to its layer, giving it one if needed.
+	 *
+	 * @throws std::runtime_error If a layer can't be created.
+	 */
+	void renderChunk(unsigned chunk) const;
+
+	/**
+	 * @brief Functions called by applyEdits().
+	 *
+	 */
+	std::vector<ChangeListener> mChangeListeners;
+
+	/**
+	 * @brief Append the quad of a single tile.
+	 *
+	 * @param pos The tile's position in the grid.
+	 * @param id The tile's ID, not air.
+	 */
+	void appendTileQuad(sf::VertexArray &vertices, sf::Vector2i pos, int id) const;
+
+	/**
+	 * @brief The atlas containing the tileset to render w/ the vertex array.
 	 *
 	 */
-	sf::VertexArray mVertices;
+	const TextureAtlas *mAtlas;
 
 	/**
-	 * @brief The tilemap to render w/ the vertex array.
+	 * @brief The area of the atlas the tileset was packed into.
 	 *
 	 */
-	sf::Texture mMapTexture;
+	sf::IntRect mTilesetRect;
 
 	//////////////MAP DATA////////////////
 
 	/**
-	 * @brief The internal vector of tile ID's.
+	 * @brief The grid of tile ID's.
+	 *
+	 * @remarks The ID corresponds to a position in the tileset,
+	 * left->right. 0 is an empty, "air" tile.
+	 */
+	TileStorage mTiles;
+
+	/**
+	 * @brief The resource left in each tile, laid out like mTiles.
 	 *
-	 * @remarks The ID corresponds to a position in the mMapTexture,
-	 * left->right. 0 is an empty, "air" tile. DO NOT USE OUTSIDE
-	 * updateVertices()
+	 * @remarks Tiles of a type start with the same amount, so the palette
+	 * stays small until they've been mined unevenly.
 	 */
-	std::vector<int> mTiles;
+	TileStorage mAmounts;
 
 	/**
 	 * @brief The dimensions of a single tile.
@@ -151,13 +340,14 @@ private:
 	 */
 	sf::Vector2i mGridDimensions;
 
-	/////////////////TILE DATA///////////////
-
 	/**
-	 * @brief A vector of all tile positions.
+	 * @brief Get the index of the tile containing a position.
 	 *
+	 * @return int The index in mTiles, or -1 if off the map.
 	 */
-	std::unordered_map<sf::Vector2f, int, Vector2Hash> mTilePositions;
+	int getTileIndex(sf::Vector2f pos);
+
+	/////////////////TILE DATA///////////////
 
 	/**
 	 * @brief The default tile data.
@@ -177,6 +367,36 @@ private:
 	 */
 	nlohmann::json mTileData;
 
+	/**
+	 * @brief The resource a tile type holds, & what it turns into once
+	 * emptied.
+	 *
+	 */
+	struct TileResource
+	{
+		unsigned amount;
+		int becomes;
+	};
+
+	/**
+	 * @brief The resource of every tile ID.
+	 *
+	 */
+	std::vector<TileResource> mResources;
+
+	/**
+	 * @brief The rules tiles grow by.
+	 *
+	 * @see resource/maps/INFO.md
+	 */
+	nlohmann::json mGrowthData;
+
+	/**
+	 * @brief Get the starting resource amount of a tile ID.
+	 *
+	 */
+	unsigned getStartingAmount(int tileID);
+
 	//////////////INITIALIZATION FUNCTIONS//////////////////
 
 	/**
@@ -200,9 +420,15 @@ private:
 	bool getTileData(nlohmann::json &tiledata);
 
 	/**
-	 * @brief Performs the final initializion of the vertices, for rendering.
+	 * @brief Reads each tile type's resource, & fills every tile with it.
+	 *
+	 * @return false If a tile becomes an unknown tile.
+	 */
+	bool initResources();
+
+	/**
+	 * @brief Drops every chunk's layer, to be rendered once it's in view.
 	 *
-	 * @return true If successful.
 	 */
-	bool updateVertices();
+	void resetChunks();
 };
\ No newline at end of file
@@ -12,7 +12,10 @@
 #include <SFML/Graphics.hpp>
 
 #include "BuildingManager.hpp"
+#include "Fixed.hpp"
+#include "KeyManager.hpp"
 #include "MaterialManager.hpp"
+#include "ModifiedStat.hpp"
 
 /**
  * @brief Provides a container for storing upgrade key-pair combos.
@@ -20,7 +23,12 @@
  * Contains a method to render the icon buttons for upgrades, and call as necessary.
  * Contains a method to load upgrades from object_data.json
  * 
- * @remarks Functions passed by lambda expressions should be by-reference to modify the actual BuildingManager properties.
+ * @remarks Each upgrade's "methods" are compiled into Effects at load time, so
+ * purchasing an upgrade never touches json. Effects push modifiers onto the
+ * building stats, rather than overwriting them.
+ *
+ * @remarks Unlocks are event-driven. Each resource keeps its unlock thresholds
+ * sorted, & only the thresholds crossed by a change are visited.
  * 
  */
 class UpgradeManager
@@ -45,12 +53,15 @@ public:
 	 * @brief Initializes all upgrades.
 	 * 
 	 * @param object_data resource/objects/object_data.json 
+	 *
+	 * @throws std::runtime_error If an upgrade method is unknown or malformed.
 	 */
 	void loadUpgradeData(nlohmann::json object_data);
 
 	/**
 	 * @brief Renders & updates the the upgrade buttons.
 	 * 
+	 * @remarks Shift+Click buys as many of the upgrade as can be afforded.
 	 */
 	void renderGui();
 
@@ -64,6 +75,67 @@ public:
 	 */
 	bool renderGuiTooltip();
 
+	/**
+	 * @brief The stat an upgrade effect modifies.
+	 *
+	 */
+	enum class EffectTarget
+	{
+		TPS,
+		PertickIn,
+		PertickOut,
+		Price,
+		SellPrice
+	};
+
+	/**
+	 * @brief A single compiled upgrade method.
+	 *
+	 */
+	struct Effect
+	{
+		EffectTarget target;
+		/// The building whose stats are modified. Unused for TPS.
+		BuildingManager::BuildingID building;
+		/// The index into the targeted cost list. Unused for TPS.
+		unsigned slot;
+		/// The modifier to push, "-" is compiled to "+".
+		ModifierType type;
+		Fixed value;
+	};
+
+	/**
+	 * @brief The mutable, pre-resolved state of a loaded upgrade.
+	 *
+	 */
+	struct UpgradeState
+	{
+		MaterialManager::Cost price;
+		MaterialManager::Cost unlock_price;
+		Fixed pricefactor;
+		/// Uses left, -1 is infinite.
+		int uses;
+		/// How many ticks the effects last, 0 is forever.
+		unsigned long long duration;
+		bool unlocked;
+		std::vector<Effect> effects;
+		/// The price's entry in the MaterialManager affordability cache.
+		MaterialManager::PurchasableID purchasable;
+	};
+
+	/**
+	 * @brief Pre-formatted tooltip contents of an upgrade.
+	 *
+	 * @remarks The price lines are reformatted after each purchase.
+	 */
+	struct UpgradeTooltip
+	{
+		sf::Sprite icon;
+		std::string name;
+		std::vector<std::string> description;
+		std::vector<BuildingManager::TooltipLine> price;
+	};
+
 private:
 	/**
 	 * @brief True if the tooltip is being rendered.
@@ -72,10 +144,10 @@ private:
 	bool mRenderTooltip;
 
 	/**
-	 * @brief A pointer to the upgrade to render the tooltip for.
+	 * @brief The index of the upgrade to render the tooltip for.
 	 * 
 	 */
-	Upgrade* tooltipUpgrade;
+	unsigned tooltipUpgrade;
 
 	/**
 	 * @brief Pointer to the global material manager.
@@ -90,23 +162,96 @@ private:
 	BuildingManager* mBuilder;
 
 	/**
-	 * @brief Attempts to purchase and call the given upgrade.
+	 * @brief The most purchases a single bulk buy will make.
 	 * 
-	 * @param upgrade The upgrade to attempt.
 	 */
-	void callUpgrade(Upgrade& upgrade);
+	const unsigned MAX_BULK_PURCHASES = 10000;
 
 	/**
-	 * @brief A map of keys to their corresponding function.
+	 * @brief Attempts to purchase and apply the given upgrade, up to count
+	 * times.
+	 *
+	 * @param index The index of the upgrade to attempt.
+	 * @param count The maximum amount of purchases to make.
+	 * @return unsigned The amount of purchases made.
+	 */
+	unsigned callUpgrade(unsigned index, unsigned count = 1);
+
+	/**
+	 * @brief Pushes the modifiers of an upgrade's effects, stacked the given
+	 * number of times.
+	 *
+	 * @param index The upgrade, used as the modifiers' source.
+	 * @param times How many purchases to apply.
+	 */
+	void applyEffects(unsigned index, unsigned times);
+
+	/**
+	 * @brief An unlock_price entry, indexed by resource.
 	 * 
 	 */
-	std::unordered_map<std::string, std::function<void(nlohmann::json::array_t)>> mUpgradeMap;
+	struct UnlockThreshold
+	{
+		BigNumber count;
+		unsigned upgrade;
+	};
 
 	/**
-	 * @brief A map of upgrade names to their button textures.
+	 * @brief The unlock thresholds of each resource, sorted by count, indexed
+	 * by ResourceID.
 	 * 
 	 */
-	std::unordered_map<std::string, sf::Texture> mUpgradeTextures;
+	std::vector<std::vector<UnlockThreshold>> mUnlockThresholds;
+
+	/**
+	 * @brief How many unlock_price entries are currently met, parallel to
+	 * mUpgrades.
+	 *
+	 */
+	std::vector<unsigned> mUnlockMet;
+
+	/**
+	 * @brief Indices of unlocked upgrades, in ascending order.
+	 *
+	 */
+	std::vector<unsigned> mUnlocked;
+
+	/**
+	 * @brief Builds the unlock threshold index & unlocks every upgrade whose
+	 * unlock price is already met.
+	 *
+	 */
+	void initUnlocks();
+
+	/**
+	 * @brief Updates the met counters for every threshold crossed by a
+	 * resource changing from old_count to new_count.
+	 *
+	 */
+	void onResourceChanged(MaterialManager::ResourceID id,
+						   const BigNumber& old_count,
+						   const BigNumber& new_count);
+
+	/**
+	 * @brief Marks an upgrade as unlocked, so it's shown in the GUI.
+	 *
+	 */
+	void unlock(unsigned index);
+
+	/**
+	 * @brief A map of method names to the function that compiles them into
+	 * Effects.
+	 *
+	 */
+	std::unordered_map<std::string,
+					   std::function<void(nlohmann::json::array_t, std::vector<Effect>&)>>
+		mMethodCompilers;
+
+	/**
+	 * @brief The button sprite of every upgrade, parallel to mUpgrades.
+	 *
+	 */
+	std::vector<sf::Sprite> mIcons;
 
 	/**
 	 * @brief A vector of all upgrades.
@@ -115,18 +260,28 @@ private:
 	std::vector<Upgrade> mUpgrades;
 
 	/**
-	 * @brief Returns the texture of the specified upgrade.
+	 * @brief The state of every upgrade, parallel to mUpgrades.
 	 * 
-	 * @param up The upgrade to retrieve.
-	 * @return sf::Texture* The texture of it.
 	 */
-	sf::Texture* getUpgradeTexture(Upgrade& up);
+	std::vector<UpgradeState> mStates;
+
+	/**
+	 * @brief The tooltip of every upgrade, parallel to mUpgrades.
+	 *
+	 */
+	std::vector<UpgradeTooltip> mTooltips;
+
+	/**
+	 * @brief Reformats the price lines of an upgrade's tooltip.
+	 *
+	 */
+	void formatTooltipPrice(unsigned index);
 
 	//////////////////////UPGRADES/////////////////////////
 
 	/**
-	 * @brief Initializes all upgrade lambdas/function objects.
+	 * @brief Initializes all upgrade method compilers.
 	 * 
 	 */
-	void initUpgradeMap();
-};
\ No newline at end of file
+	void initMethodCompilers();
+};
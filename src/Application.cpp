@@ -1,14 +1,19 @@
 #include "Application.hpp"
 
+#include <cmath>
+
 Application::Application()
 	: mWindow(sf::VideoMode(WINDOW_SIZE.x, WINDOW_SIZE.y),
 			  "Miner",
 			  sf::Style::Titlebar | sf::Style::Close),
-	  mMap("map"),
-	  mBuilder(&mMap),
+	  mAtlas({"resource/objects/textures", "resource/maps"}),
+	  mMap("map", &mAtlas),
+	  mBuilder(&mMap, &mAtlas),
 	  mUpgrades(&mBuilder)
 {
 	mWindow.setFramerateLimit(60);
+	mRedrawFrames = REDRAW_FRAMES;
+	mFocused	  = true;
 
 	// Init ImGui
 	ImGui::SFML::Init(mWindow);
@@ -17,8 +22,29 @@ Application::Application()
 	//Init the UpgradeManager.
 	mUpgrades.loadUpgradeData(mBuilder.getObjectData());
 
+	// Init the map view, covering the area left of & above the GUI.
+	sf::Vector2f map_area = (sf::Vector2f)(WINDOW_SIZE - GUI_SIZE);
+	mMapView.reset(sf::FloatRect(0, 0, map_area.x, map_area.y));
+	mMapView.setViewport(sf::FloatRect(0,
+									   0,
+									   map_area.x / WINDOW_SIZE.x,
+									   map_area.y / WINDOW_SIZE.y));
+	mZoom = 1;
+
+	// Init the minimap.
+	mMinimap.init(mMap.getGridSize(),
+				  mMap.getTileColors(),
+				  mBuilder.getBuildingColors());
+	mMinimap.setScale(mMap.getTileSize());
+	mMap.attachMinimap(&mMinimap);
+	mBuilder.attachMinimap(&mMinimap);
+
+	// Start the tiles growing.
+	mGrowth.init(&mMap);
+
 	// Init the keyboard manager
 	KeyManager::setWindowReference(&mWindow);
+	KeyManager::setMapView(&mMapView);
 }
 
 int Application::run()
@@ -32,34 +58,64 @@ int Application::run()
 		sf::Event event;
 		while (mWindow.pollEvent(event))
 		{
-			// Update ImGui
-			ImGui::SFML::ProcessEvent(event);
-
-			// Update SFML
-			switch (event.type)
-			{
-			default:
-				break;
-			case sf::Event::Closed:
-				mWindow.close();
-				break;
-			}
+			handleEvent(event);
 		}
 
 		// Update the keyboard manager.
 		KeyManager::update();
 
+		// Only run the GUI on frames that are rendered.
+		bool drawing = shouldRedraw();
+
 		// Update the GUI.
-		mUpdateGui();
+		if (drawing)
+		{
+			mUpdateGui();
+		}
 
 		// Update the building manager
 		mBuilder.update();
 
+		// Grow the map, redrawing whatever changed.
+		if (mGrowth.update())
+		{
+			requestRedraw();
+		}
+
+		// Render the result of ticks & placements.
+		if (mBuilder.pollChanged())
+		{
+			requestRedraw();
+		}
+		if (mMinimap.update())
+		{
+			requestRedraw();
+		}
+
+		// Nothing to draw, wait for the next update.
+		if (!drawing)
+		{
+			idle();
+			continue;
+		}
+		mRedrawFrames--;
+		mUnfocusedClock.restart();
+
 		// Start drawing.
 		mWindow.clear(BG_COLOR);
 
-		mWindow.draw(mMap);
-		mWindow.draw(mBuilder);
+		// Draw the map through the map view, as the minimap if zoomed out.
+		mWindow.setView(mMapView);
+		if (mZoom >= LOD_ZOOM)
+		{
+			mWindow.draw(mMinimap);
+		}
+		else
+		{
+			mWindow.draw(mMap);
+			mWindow.draw(mBuilder);
+		}
+		mWindow.setView(mWindow.getDefaultView());
 
 		// Render ImGui last.
 		ImGui::SFML::Render(mWindow);
@@ -73,13 +129,129 @@ int Application::run()
 	return 0;
 }
 
+void Application::requestRedraw()
+{
+	mRedrawFrames = REDRAW_FRAMES;
+}
+
+bool Application::shouldRedraw() const
+{
+	if (mRedrawFrames == 0)
+	{
+		return false;
+	}
+
+	// Throttle frames while unfocused.
+	return mFocused ||
+		   mUnfocusedClock.getElapsedTime() >= UNFOCUSED_FRAME_TIME;
+}
+
+void Application::handleEvent(const sf::Event &event)
+{
+	// Update ImGui
+	ImGui::SFML::ProcessEvent(event);
+
+	// Update the keyboard manager's state.
+	KeyManager::handleEvent(event);
+
+	// Any event may change what's on screen.
+	requestRedraw();
+
+	// Update SFML
+	switch (event.type)
+	{
+	default:
+		break;
+	case sf::Event::Closed:
+		mWindow.close();
+		break;
+	case sf::Event::LostFocus:
+		mFocused = false;
+		break;
+	case sf::Event::GainedFocus:
+		mFocused = true;
+		break;
+	case sf::Event::MouseWheelScrolled:
+		// Zoom the map, unless scrolling the GUI.
+		if (!ImGui::GetIO().WantCaptureMouse &&
+			event.mouseWheelScroll.wheel == sf::Mouse::VerticalWheel)
+		{
+			zoomMap(std::pow(1.25f, -event.mouseWheelScroll.delta));
+		}
+		break;
+	}
+}
+
+void Application::idle()
+{
+	// Wake for the next tick, growth step, or allowed frame.
+	sf::Time wait =
+		std::min(mBuilder.getTimeUntilTick(), mGrowth.getTimeUntilStep());
+	if (mRedrawFrames != 0)
+	{
+		wait = std::min(wait,
+						UNFOCUSED_FRAME_TIME - mUnfocusedClock.getElapsedTime());
+	}
+	if (wait <= sf::Time::Zero)
+	{
+		return;
+	}
+
+	// Input can wait too while unfocused.
+	if (!mFocused)
+	{
+		sf::sleep(wait);
+		return;
+	}
+
+	// Otherwise wait on events. SFML can't time out waitEvent(), so check
+	// for them every INPUT_POLL_TIME instead.
+	sf::Clock waited;
+	sf::Event event;
+	while (!mWindow.pollEvent(event))
+	{
+		sf::Time left = wait - waited.getElapsedTime();
+		if (left <= sf::Time::Zero)
+		{
+			return;
+		}
+		sf::sleep(std::min(left, INPUT_POLL_TIME));
+	}
+	handleEvent(event);
+}
+
+void Application::zoomMap(float factor)
+{
+	float zoom = std::max(MIN_ZOOM, std::min(mZoom * factor, MAX_ZOOM));
+	mMapView.zoom(zoom / mZoom);
+	mZoom = zoom;
+}
+
+void Application::renderGuiMinimap()
+{
+	// Fit the minimap in the panel, keeping its aspect ratio.
+	sf::Vector2f grid = (sf::Vector2f)mMap.getGridSize();
+	float scale		  = std::min(240.0f / grid.x, 120.0f / grid.y);
+	sf::Vector2f size = grid * scale;
+
+	ImGui::Image(mMinimap.getTexture(), size);
+
+	// Center the map view on the clicked tile.
+	if (ImGui::IsItemClicked())
+	{
+		ImVec2 min	 = ImGui::GetItemRectMin();
+		ImVec2 mouse = ImGui::GetMousePos();
+		sf::Vector2f tile_size = mMap.getTileSize();
+		mMapView.setCenter((mouse.x - min.x) / scale * tile_size.x,
+						   (mouse.y - min.y) / scale * tile_size.y);
+	}
+}
+
 void Application::mUpdateGui()
 {
 
 	//Get the right-bottom coordinate of the map.
-	sf::Vector2i bottom_right = {
-		WINDOW_SIZE.x - 260,
-		WINDOW_SIZE.y - 200};
+	sf::Vector2i bottom_right = WINDOW_SIZE - GUI_SIZE;
 
 	// Update ImGui
 	ImGui::SFML::Update(mWindow, mImGuiClock.restart());
@@ -124,6 +296,18 @@ void Application::mUpdateGui()
 
 	ImGui::EndChild();
 
+	ImGui::SameLine();
+
+	//Create a child container for the blueprint buttons.
+	ImGui::BeginChild("BlueprintButtons",
+					  ImVec2(150, 180),
+					  true,
+					  default_flags & ~ImGuiWindowFlags_NoTitleBar);
+
+	mBuilder.renderGuiBlueprints();
+
+	ImGui::EndChild();
+
 	// Stop initializing imgui window componenets.
 	ImGui::End();
 	////////////////////////////////////////////////////////
@@ -144,6 +328,11 @@ void Application::mUpdateGui()
 	// Render the resource counts with their icons.
 	mBuilder.renderGuiResources();
 
+	// Render the minimap below.
+	ImGui::Columns(1);
+	ImGui::Separator();
+	renderGuiMinimap();
+
 	ImGui::End();
 	//////////////////////////////////////////////////////
 
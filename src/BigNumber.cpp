@@ -0,0 +1,336 @@
+#include "BigNumber.hpp"
+
+#include <climits>
+#include <cstdio>
+#include <stdexcept>
+
+namespace
+{
+// The limits of the storage type.
+const BigNumber::value_type RAW_MAX =
+	(BigNumber::value_type)(~(unsigned __int128)0 >> 1);
+const BigNumber::value_type RAW_MIN = -RAW_MAX - 1;
+
+// Suffixes for format(), one per power of 1000.
+const char *SUFFIXES[] = {"",
+						  "K",
+						  "M",
+						  "B",
+						  "T",
+						  "Qa",
+						  "Qi",
+						  "Sx",
+						  "Sp",
+						  "Oc",
+						  "No",
+						  "Dc",
+						  "Ud"};
+const int SUFFIX_COUNT = sizeof(SUFFIXES) / sizeof(SUFFIXES[0]);
+}
+
+BigNumber::BigNumber()
+	: mValue(0)
+{
+}
+
+BigNumber::BigNumber(long long value)
+	: mValue(value)
+{
+}
+
+BigNumber BigNumber::fromDouble(double value)
+{
+	// NaN has no sensible count.
+	if (std::isnan(value))
+	{
+		return BigNumber();
+	}
+
+	// Saturate anything out of range (2^127 ~= 1.7e38).
+	value = std::round(value);
+	if (value >= 1.7e38)
+	{
+		return max();
+	}
+	if (value <= -1.7e38)
+	{
+		return min();
+	}
+
+	return fromRaw((value_type)value);
+}
+
+BigNumber BigNumber::fromString(const std::string &str)
+{
+	// Handle the sign.
+	size_t i	  = 0;
+	bool negative = false;
+	if (i < str.size() && (str[i] == '-' || str[i] == '+'))
+	{
+		negative = str[i] == '-';
+		++i;
+	}
+
+	if (i == str.size())
+	{
+		throw std::invalid_argument("BigNumber -- empty string.");
+	}
+
+	// Accumulate every digit, saturating on overflow.
+	BigNumber ret;
+	for (; i < str.size(); ++i)
+	{
+		if (str[i] < '0' || str[i] > '9')
+		{
+			throw std::invalid_argument("BigNumber -- invalid digit in " + str);
+		}
+		ret = ret * 10 + (str[i] - '0');
+	}
+
+	return negative ? -ret : ret;
+}
+
+BigNumber BigNumber::fromRaw(value_type raw)
+{
+	BigNumber ret;
+	ret.mValue = raw;
+	return ret;
+}
+
+BigNumber BigNumber::max()
+{
+	return fromRaw(RAW_MAX);
+}
+
+BigNumber BigNumber::min()
+{
+	return fromRaw(RAW_MIN);
+}
+
+BigNumber::value_type BigNumber::raw() const
+{
+	return mValue;
+}
+
+double BigNumber::toDouble() const
+{
+	return (double)mValue;
+}
+
+long long BigNumber::toLong() const
+{
+	if (mValue > LLONG_MAX)
+	{
+		return LLONG_MAX;
+	}
+	if (mValue < LLONG_MIN)
+	{
+		return LLONG_MIN;
+	}
+	return (long long)mValue;
+}
+
+bool BigNumber::fitsLong() const
+{
+	return mValue <= LLONG_MAX && mValue >= LLONG_MIN;
+}
+
+std::string BigNumber::toString() const
+{
+	if (mValue == 0)
+	{
+		return "0";
+	}
+
+	// Work on the magnitude as unsigned, so MIN doesn't overflow.
+	unsigned __int128 mag = (mValue < 0) ? -(unsigned __int128)mValue
+										 : (unsigned __int128)mValue;
+
+	// Extract the digits, least significant first.
+	std::string ret;
+	while (mag != 0)
+	{
+		ret.push_back('0' + (int)(mag % 10));
+		mag /= 10;
+	}
+	if (mValue < 0)
+	{
+		ret.push_back('-');
+	}
+
+	return std::string(ret.rbegin(), ret.rend());
+}
+
+std::string BigNumber::format() const
+{
+	unsigned __int128 mag = (mValue < 0) ? -(unsigned __int128)mValue
+										 : (unsigned __int128)mValue;
+
+	// Render small values exactly.
+	if (mag < 1000000)
+	{
+		return toString();
+	}
+
+	// Find the largest power of 1000 that's <= the value.
+	int suffix			  = 0;
+	unsigned __int128 div = 1;
+	while (suffix + 1 < SUFFIX_COUNT && mag / div >= 1000)
+	{
+		div *= 1000;
+		++suffix;
+	}
+
+	// Whole part & two truncated decimals.
+	unsigned __int128 whole = mag / div;
+	unsigned __int128 frac  = (mag % div) / (div / 100);
+
+	char buf[64];
+	snprintf(buf,
+			 sizeof(buf),
+			 "%s%llu.%02u%s",
+			 (mValue < 0) ? "-" : "",
+			 (unsigned long long)whole,
+			 (unsigned)frac,
+			 SUFFIXES[suffix]);
+	return buf;
+}
+
+BigNumber &BigNumber::operator+=(const BigNumber &rhs)
+{
+	if (__builtin_add_overflow(mValue, rhs.mValue, &mValue))
+	{
+		mValue = (rhs.mValue > 0) ? RAW_MAX : RAW_MIN;
+	}
+	return *this;
+}
+
+BigNumber &BigNumber::operator-=(const BigNumber &rhs)
+{
+	if (__builtin_sub_overflow(mValue, rhs.mValue, &mValue))
+	{
+		mValue = (rhs.mValue < 0) ? RAW_MAX : RAW_MIN;
+	}
+	return *this;
+}
+
+BigNumber &BigNumber::operator*=(const BigNumber &rhs)
+{
+	// Grab the sign before the builtin overwrites mValue.
+	bool negative = (mValue < 0) != (rhs.mValue < 0);
+	if (__builtin_mul_overflow(mValue, rhs.mValue, &mValue))
+	{
+		mValue = negative ? RAW_MIN : RAW_MAX;
+	}
+	return *this;
+}
+
+BigNumber &BigNumber::operator/=(const BigNumber &rhs)
+{
+	// Division by zero saturates, like the float path used to.
+	if (rhs.mValue == 0)
+	{
+		mValue = (mValue < 0) ? RAW_MIN : (mValue > 0) ? RAW_MAX : 0;
+		return *this;
+	}
+	// The only overflowing division.
+	if (mValue == RAW_MIN && rhs.mValue == -1)
+	{
+		mValue = RAW_MAX;
+		return *this;
+	}
+	mValue /= rhs.mValue;
+	return *this;
+}
+
+BigNumber operator+(BigNumber lhs, const BigNumber &rhs)
+{
+	return lhs += rhs;
+}
+
+BigNumber operator-(BigNumber lhs, const BigNumber &rhs)
+{
+	return lhs -= rhs;
+}
+
+BigNumber operator*(BigNumber lhs, const BigNumber &rhs)
+{
+	return lhs *= rhs;
+}
+
+BigNumber operator/(BigNumber lhs, const BigNumber &rhs)
+{
+	return lhs /= rhs;
+}
+
+BigNumber operator-(const BigNumber &v)
+{
+	return BigNumber() - v;
+}
+
+bool operator==(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue == rhs.mValue;
+}
+
+bool operator!=(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue != rhs.mValue;
+}
+
+bool operator<(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue < rhs.mValue;
+}
+
+bool operator>(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue > rhs.mValue;
+}
+
+bool operator<=(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue <= rhs.mValue;
+}
+
+bool operator>=(const BigNumber &lhs, const BigNumber &rhs)
+{
+	return lhs.mValue >= rhs.mValue;
+}
+
+void to_json(nlohmann::json &j, const BigNumber &n)
+{
+	// Keep small values as plain numbers, so the json stays readable.
+	if (n.fitsLong())
+	{
+		j = n.toLong();
+	}
+	else
+	{
+		j = n.toString();
+	}
+}
+
+void from_json(const nlohmann::json &j, BigNumber &n)
+{
+	if (j.is_number_unsigned())
+	{
+		n = BigNumber::fromRaw(j.get<unsigned long long>());
+	}
+	else if (j.is_number_integer())
+	{
+		n = BigNumber(j.get<long long>());
+	}
+	else if (j.is_number_float())
+	{
+		n = BigNumber::fromDouble(j.get<double>());
+	}
+	else if (j.is_string())
+	{
+		n = BigNumber::fromString(j.get<std::string>());
+	}
+	else
+	{
+		throw std::invalid_argument("BigNumber -- json value is not a number.");
+	}
+}
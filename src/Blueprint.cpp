@@ -0,0 +1,75 @@
+#include "Blueprint.hpp"
+
+Blueprint::Blueprint()
+{
+	mSize = {0, 0};
+}
+
+void Blueprint::addCell(sf::Vector2i offset, unsigned building)
+{
+	mCells.push_back({.offset = offset, .building = building});
+
+	// Grow the bounding box to contain the cell.
+	mSize.x = std::max(mSize.x, offset.x + 1);
+	mSize.y = std::max(mSize.y, offset.y + 1);
+}
+
+const std::vector<Blueprint::Cell> &Blueprint::getCells() const
+{
+	return mCells;
+}
+
+sf::Vector2i Blueprint::getSize() const
+{
+	return mSize;
+}
+
+bool Blueprint::empty() const
+{
+	return mCells.empty();
+}
+
+nlohmann::json Blueprint::toJson(const std::vector<std::string> &names) const
+{
+	nlohmann::json ret;
+	ret["buildings"] = nlohmann::json::array();
+	ret["cells"]	 = nlohmann::json::array();
+
+	// Name each building used once, & refer to it by its palette index.
+	std::vector<int> palette(names.size(), -1);
+	for (auto &i : mCells)
+	{
+		if (palette[i.building] == -1)
+		{
+			palette[i.building] = ret["buildings"].size();
+			ret["buildings"].push_back(names[i.building]);
+		}
+		ret["cells"].push_back({i.offset.x, i.offset.y, palette[i.building]});
+	}
+
+	return ret;
+}
+
+Blueprint Blueprint::fromJson(const nlohmann::json &data,
+							  const std::function<unsigned(const std::string &)> &resolve)
+{
+	// Resolve the palette of names to IDs.
+	std::vector<unsigned> palette;
+	for (auto &i : data.at("buildings"))
+	{
+		palette.push_back(resolve(i.get<std::string>()));
+	}
+
+	Blueprint ret;
+	for (auto &i : data.at("cells"))
+	{
+		sf::Vector2i offset(i.at(0).get<int>(), i.at(1).get<int>());
+		if (offset.x < 0 || offset.y < 0)
+		{
+			throw std::runtime_error("Blueprint cell has a negative offset.");
+		}
+		ret.addCell(offset, palette.at(i.at(2).get<unsigned>()));
+	}
+
+	return ret;
+}
@@ -1,11 +1,21 @@
 #include "BuildingManager.hpp"
 
-BuildingManager::BuildingManager(Tilemap *map)
+BuildingManager::BuildingManager(Tilemap *map, const TextureAtlas *atlas)
 {
 	// Initialize defaults.
 	mMap	   = map;
+	mAtlas	   = atlas;
+	mMinimap   = nullptr;
 	mBuildMode = false;
-	mTPS	   = 1;
+	mDragging  = false;
+	mSelling   = false;
+	mBlueprintMode = BlueprintMode::None;
+	mPasteDirty	   = true;
+	mMaxFootprint  = {1, 1};
+	mTPS	   = ModifiedStat<Fixed>(1);
+	mTickCount  = 0;
+	mNextExpiry = 0;
+	mChanged	= true;
 	mGlobalClock.restart();
 
 	// Attempt to initialize buildings...
@@ -14,9 +24,40 @@ BuildingManager::BuildingManager(Tilemap *map)
 		throw std::runtime_error("Building initialization failed.");
 	}
 
+	// Init the occupancy grid & render chunks.
+	sf::Vector2i grid = mMap->getGridSize();
+	mLayout = GridLayout(grid);
+	mOccupancy.assign(mLayout.getStorageSize(), -1);
+	mChunkCount = {(grid.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+				   (grid.y + CHUNK_SIZE - 1) / CHUNK_SIZE};
+
+	// Read the bonuses, which need the grid to count neighbours on.
+	initBonuses();
+
+	std::vector<sf::IntRect> sprites;
+	std::vector<sf::Vector2i> footprints;
+	for (BuildingID i = 0; i < mBuildingSprites.size(); ++i)
+	{
+		sprites.push_back(mBuildingSprites[i].getTextureRect());
+		footprints.push_back(mStats[i].footprint);
+	}
+	mChunkBuilder.init(grid, mMap->getTileSize(), CHUNK_SIZE, sprites, footprints);
+
+	// Init the placement overlay, rebuilt per chunk as tiles change.
+	mOverlayBuilding = -1;
+	mOverlayChunks.assign(mChunkCount.x * mChunkCount.y, sf::VertexArray(sf::Quads));
+	mOverlayChunkDirty.assign(mOverlayChunks.size(), true);
+	mMap->addChangeListener([this](const Tilemap::TileChange &change) {
+		for (unsigned i : change.tiles)
+		{
+			markOverlayDirty(i);
+		}
+	});
+
 	//Init the highlight rectangle.
 	mHighlightRect.setSize(mMap->getTileSize());
 	mDrawHighlight = false;
+	mSellRect.setFillColor(HIGHLIGHT.at("SELL"));
 
 	// Add starter materials.
 	mMaterials.addResources({.name = "Cash", .count = 10});
@@ -25,23 +66,65 @@ BuildingManager::BuildingManager(Tilemap *map)
 void BuildingManager::draw(sf::RenderTarget &target,
 						   sf::RenderStates states) const
 {
-	// Draw all built buildings.
-	for (auto &i : mBuilt)
+	// Get the visible area.
+	const sf::View &view = target.getView();
+	sf::FloatRect visible(view.getCenter() - view.getSize() / 2.0f,
+						  view.getSize());
+	sf::Vector2f tile_size	= mMap->getTileSize();
+	sf::Vector2f chunk_size = tile_size * (float)CHUNK_SIZE;
+
+	// Draw all built buildings, one call per visible chunk. Buildings belong
+	// to the chunk of their top left tile, so can overhang it.
+	sf::RenderStates chunk_states = states;
+	chunk_states.texture		  = &mAtlas->getTexture();
+	const std::vector<sf::VertexArray> &chunks = mChunkBuilder.getChunks();
+	for (int i = 0; i < (int)chunks.size(); ++i)
 	{
-		target.draw(i.spr, states);
+		sf::FloatRect bounds((i % mChunkCount.x) * chunk_size.x,
+							 (i / mChunkCount.x) * chunk_size.y,
+							 chunk_size.x + (mMaxFootprint.x - 1) * tile_size.x,
+							 chunk_size.y + (mMaxFootprint.y - 1) * tile_size.y);
+		if (chunks[i].getVertexCount() != 0 && visible.intersects(bounds))
+		{
+			target.draw(chunks[i], chunk_states);
+		}
 	}
 
 	// If attempting to place a building...
 	if (mBuildMode)
 	{
+		// Shade every tile it can be placed on.
+		for (int i = 0; i < (int)mOverlayChunks.size(); ++i)
+		{
+			sf::FloatRect bounds((i % mChunkCount.x) * chunk_size.x,
+								 (i / mChunkCount.x) * chunk_size.y,
+								 chunk_size.x,
+								 chunk_size.y);
+			if (mOverlayChunks[i].getVertexCount() != 0 &&
+				!mOverlayChunkDirty[i] && visible.intersects(bounds))
+			{
+				target.draw(mOverlayChunks[i], states);
+			}
+		}
+
 		// Draw the held building sprite.
 		target.draw(mBuildingSprite, states);
 	}
+	// Draw the held blueprint.
+	if (mBlueprintMode == BlueprintMode::Paste)
+	{
+		target.draw(mGhost, chunk_states);
+	}
 	//If the highlight should be drawn, draw it.
 	if (mDrawHighlight)
 	{
 		target.draw(mHighlightRect, states);
 	}
+	//Cover the region being sold.
+	if (mSelling)
+	{
+		target.draw(mSellRect, states);
+	}
 }
 
 nlohmann::json &BuildingManager::getObjectData()
@@ -54,6 +137,30 @@ MaterialManager *BuildingManager::getMaterialManager()
 	return &mMaterials;
 }
 
+const TextureAtlas *BuildingManager::getAtlas()
+{
+	return mAtlas;
+}
+
+std::vector<sf::Color> BuildingManager::getBuildingColors()
+{
+	std::vector<sf::Color> colors;
+	for (auto &i : mBuildingSprites)
+	{
+		colors.push_back(mAtlas->getAverageColor(i.getTextureRect()));
+	}
+	return colors;
+}
+
+void BuildingManager::attachMinimap(Minimap *minimap)
+{
+	mMinimap = minimap;
+	mMinimap->setBuildingSource([this](unsigned tile) {
+		int building = getOccupant(tile);
+		return building == -1 ? -1 : (int)mBuilt[building].id;
+	});
+}
+
 void BuildingManager::renderGuiBuildings()
 {
 	// Boolean used to check if nothing at all is hovered.
@@ -61,10 +168,8 @@ void BuildingManager::renderGuiBuildings()
 	// For every building...
 	for (auto &i : mBuildings)
 	{
-		std::vector<MaterialManager::Resource> resource_cost = mMaterials.priceToResourceVector(i.at("price").get<nlohmann::json::array_t>());
-
 		//Check if it's purchaseable, to set the tint of the button.
-		bool canPurchase	= mMaterials.canPurchaseMultiple(resource_cost);
+		bool canPurchase	= mMaterials.isAffordable(mStats[getBuildingID(i)].purchasable);
 		sf::Color tintColor = sf::Color::White;
 		sf::Color bgColor   = sf::Color::Transparent;
 
@@ -76,7 +181,7 @@ void BuildingManager::renderGuiBuildings()
 		}
 
 		// Create a building button, and begin placing a building if pressed.
-		if (ImGui::ImageButton(*getBuildingTexture(i), 1, bgColor, tintColor))
+		if (ImGui::ImageButton(getBuildingSprite(i), 1, bgColor, tintColor))
 		{
 			placeBuilding(&i);
 		}
@@ -101,17 +206,19 @@ void BuildingManager::renderGuiBuildings()
 void BuildingManager::renderGuiResources()
 {
 	// For every resource...
-	for (auto &i : mMaterials.getResources())
+	for (MaterialManager::ResourceID i = 0;
+		 i < mMaterials.getResourceTypeCount();
+		 ++i)
 	{
 		// Add an image for it.
-		ImGui::Image(*mMaterials.getTexture(i.first));
+		ImGui::Image(mMaterials.getIcon(i));
 		ImGui::NextColumn();
 
-		float rpt = mMaterials.getAverageResourcePerTick(i.first);
+		float rpt = mMaterials.getAverageResourcePerTick(i);
 
 		// Add the name of it...
 		ImGui::Text("%s",
-					i.first.c_str());
+					mMaterials.getResourceName(i).c_str());
 
 		ImGui::NextColumn();
 
@@ -119,8 +226,8 @@ void BuildingManager::renderGuiResources()
 		ImGui::NextColumn();
 
 		//And then the count & rpt.
-		ImGui::Text("%ld",
-					i.second);
+		ImGui::Text("%s",
+					mMaterials.getResourceCount(i).format().c_str());
 
 		ImGui::SameLine();
 
@@ -164,17 +271,12 @@ void BuildingManager::renderGuiTooltip()
 	bool mapBuildingHovered				 = false;
 	Building *mapBuildingHoveredBuilding = nullptr;
 	// Check if building on map is hovered...
-	for (auto &i : mBuilt)
+	int hovered_tile = getTileIndex(KeyManager::getMapMousePos());
+	if (hovered_tile != -1 && getOccupant(hovered_tile) != -1)
 	{
-		// If the sprite contains the mouse's position...
-		if (i.spr.getGlobalBounds().contains(
-				(sf::Vector2f)KeyManager::getMousePos()))
-		{
-			// We're hovering, grab a pointer to the hovered building and break.
-			mapBuildingHovered		   = true;
-			mapBuildingHoveredBuilding = i.building_data;
-			break;
-		}
+		// We're hovering, grab a pointer to the hovered building.
+		mapBuildingHovered		   = true;
+		mapBuildingHoveredBuilding = &mBuildings[mBuilt[getOccupant(hovered_tile)].id];
 	}
 
 	// Build mode check..
@@ -189,11 +291,28 @@ void BuildingManager::renderGuiTooltip()
 	else if (mapBuildingHovered)   // If a building on the map is hovered..
 	{
 		renderGuiBuilding(*mapBuildingHoveredBuilding, true);
+
+		// Show what its neighbours add to its output.
+		const BuildingEntityData &built = mBuilt[getOccupant(hovered_tile)];
+		if (built.multiplier != Fixed(1))
+		{
+			ImGui::Text("Output bonus: x%.2f", built.multiplier.toDouble());
+		}
+
+		// & how long its tiles will last.
+		if (mStats[built.id].extracts != 0)
+		{
+			unsigned left = 0;
+			forFootprint(built.id, built.tile, [&](unsigned tile) {
+				left += mMap->getAmountAt(tile);
+			});
+			ImGui::Text("Resource left: %u", left);
+		}
 	}
 	else   // If neither...
 	{
 		// Render the TPS & the game time elapsed.
-		ImGui::Text("Ticks/Second: %.2f\n---\n", mTPS);
+		ImGui::Text("Ticks/Second: %.2f\n---\n", mTPS.get().toDouble());
 		ImGui::Text("Time Elapsed: %d sec.",
 					(int)mGlobalClock.getElapsedTime().asSeconds());
 	}
@@ -210,23 +329,24 @@ void BuildingManager::renderGuiBuilding(BuildingManager::Building &building,
 			* Resource I/O
 			* Price
 	*/
+	BuildingID id				   = getBuildingID(building);
+	const BuildingTooltip &tooltip = getTooltip(id);
+
 	// Render the icon of the building.
-	ImGui::Image(*getBuildingTexture(building));
+	ImGui::Image(getBuildingSprite(building));
 	// Render how many are currently on-screen.
 	ImGui::SameLine();
-	ImGui::Text("Count: %d",
-				getBuildingCount(building.at("name").get<std::string>()));
+	ImGui::Text("Count: %d", mBuiltCounts[id]);
 
 	// Render the name of the building.
-	ImGui::Text("%s\n",
-				building.at("name").get<std::string>().c_str());
+	ImGui::Text("%s\n", tooltip.name.c_str());
 
 	//Render the description strings.
 	ImGui::Text(">");
 	ImGui::SameLine();
-	for (auto &i : building.at("description").get<nlohmann::json::array_t>())
+	for (auto &i : tooltip.description)
 	{
-		ImGui::Text("%s", i.get<std::string>().c_str());
+		ImGui::Text("%s", i.c_str());
 	}
 	ImGui::Text("---");
 
@@ -235,132 +355,620 @@ void BuildingManager::renderGuiBuilding(BuildingManager::Building &building,
 	{
 		// Begin rendering the sell price.
 		ImGui::Text("Sells for:");
-		// So for each element of the total cost..
-		for (auto &i : building.at("sellprice"))
-		{
-			// Render the icon.
-			ImGui::Image(
-				*mMaterials.getTexture(i.at("name").get<std::string>()));
-			// Render the name & count
-			ImGui::SameLine();
-			ImGui::Text("%ld %s",
-						i.at("count").get<long>(),
-						i.at("name").get<std::string>().c_str());
-		}
+		renderGuiLines(tooltip.sellprice);
 	}
 	// Otherwise...
 	else
 	{
 		// Render the cost.
 		ImGui::Text("Cost:");
-		// So for each element of the total cost..
-		for (auto &i : building.at("price"))
-		{
-			// Render the icon.
-			ImGui::Image(
-				*mMaterials.getTexture(i.at("name").get<std::string>()));
-			// Render the name & count
-			ImGui::SameLine();
-			ImGui::Text("%ld %s",
-						i.at("count").get<long>(),
-						i.at("name").get<std::string>().c_str());
-		}
+		renderGuiLines(tooltip.price);
 	}
 
 	// Render the resource I/O..
-	if (building.at("pertick").at("resource_in").size() != 0)
+	if (tooltip.resource_in.size() != 0)
 		ImGui::Text("Input/Tick:");
-	// Get all necessary input resources.
-	for (auto &i : building.at("pertick").at("resource_in"))
-	{
-		std::string name = i.at("name").get<std::string>();
-		long count		 = i.at("count").get<long>();
-
-		// Render the icon.
-		ImGui::Image(*mMaterials.getTexture(name));
-		// Render the name & count
-		ImGui::SameLine();
-		ImGui::Text("%ld %s", count, name.c_str());
-	}
+	renderGuiLines(tooltip.resource_in);
 
 	// Now for out I/O...
-	if (building.at("pertick").at("resource_out").size() != 0)
+	if (tooltip.resource_out.size() != 0)
 		ImGui::Text("Output/Tick:");
-	// Get all necessary output resources.
-	for (auto &i : building.at("pertick").at("resource_out"))
-	{
-		std::string name = i.at("name").get<std::string>();
-		long count		 = i.at("count").get<long>();
-
-		// Render the icon.
-		ImGui::Image(*mMaterials.getTexture(name));
-		// Render the name & count
-		ImGui::SameLine();
-		ImGui::Text("%ld %s", count, name.c_str());
-	}
+	renderGuiLines(tooltip.resource_out);
 
 	// Render what it's placeable on.
 	if (!isHighlightedOnMap)
 	{
 		ImGui::Text("Can place on:");
+		renderGuiLines(tooltip.canbuildon);
+	}
+}
 
-		// For every placeable tile...
-		for (auto &i :
-			 building.at("canbuildon").get<std::vector<std::string>>())
-		{
-			// Render its icon.
-			ImGui::Image(mMap->getTileMapTexture(),
-						 mMap->getTileTextureRect(i));
+const BuildingManager::BuildingTooltip &BuildingManager::getTooltip(BuildingID id)
+{
+	BuildingTooltip &tooltip = mTooltips[id];
+
+	// Reformat the costs if they've been upgraded.
+	if (tooltip.dirty)
+	{
+		BuildingStats &stats = mStats[id];
+		formatCost(stats.price, tooltip.price);
+		formatCost(stats.sellprice, tooltip.sellprice);
+		formatCost(stats.resource_in, tooltip.resource_in);
+		formatCost(stats.resource_out, tooltip.resource_out);
+		tooltip.dirty = false;
+	}
 
-			// Render the name.
-			ImGui::SameLine();
-			ImGui::Text("%s", i.c_str());
+	return tooltip;
+}
+
+void BuildingManager::invalidateTooltip(BuildingID id)
+{
+	mTooltips[id].dirty = true;
+}
+
+void BuildingManager::formatCost(const ModifiedCost &cost,
+								 std::vector<TooltipLine> &out)
+{
+	const MaterialManager::Cost &current = cost.get();
+	const MaterialManager::Cost &base	= cost.getBase();
+
+	out.clear();
+	// So for each element of the total cost..
+	for (unsigned i = 0; i < current.size(); ++i)
+	{
+		// The count & name..
+		std::string text = current[i].count.format() + " " +
+						   mMaterials.getResourceName(current[i].id);
+
+		// ..and the base count, if it's been modified.
+		if (current[i].count != base[i].count)
+		{
+			text += " (base " + base[i].count.format() + ")";
 		}
+
+		out.push_back({.icon = mMaterials.getIcon(current[i].id),
+					   .text = text});
+	}
+}
+
+void BuildingManager::renderGuiLines(const std::vector<TooltipLine> &lines)
+{
+	for (auto &i : lines)
+	{
+		// Render the icon.
+		ImGui::Image(i.icon);
+
+		// Render the text.
+		ImGui::SameLine();
+		ImGui::Text("%s", i.text.c_str());
 	}
 }
 
 void BuildingManager::update()
 {
+	// Swap in any chunks the worker finished, & draw them.
+	if (mChunkBuilder.collect())
+	{
+		mChanged = true;
+	}
+
 	// Update build mode.
 	updateBuilding();
+	updateBlueprint();
 
 	// If ready to update a tick...
-	if (mTickClock.getElapsedTime() > sf::seconds(1.0f / mTPS))
+	if (mTickClock.getElapsedTime() > sf::seconds(1.0f / mTPS.get().toDouble()))
 	{
 		// Update the tick.
 		updateTick();
+		mChanged = true;
 
 		mTickClock.restart();
 	}
 
-	// Check if hovering a building on the map.
-	for (auto i = mBuilt.begin(); i != mBuilt.end();)
+	// Sell buildings dragged over with the right mouse button.
+	updateSelling();
+
+	// Report this frame's resource changes.
+	mMaterials.flushChanges();
+
+	// Hand this frame's placements to the chunk worker.
+	mChunkBuilder.flush();
+}
+
+bool BuildingManager::pollChanged()
+{
+	bool changed = mChanged;
+	mChanged	 = false;
+	return changed;
+}
+
+sf::Time BuildingManager::getTimeUntilTick() const
+{
+	return sf::seconds(1.0f / mTPS.get().toDouble()) -
+		   mTickClock.getElapsedTime();
+}
+
+int BuildingManager::getTileIndex(sf::Vector2f pos)
+{
+	sf::Vector2f tile_size = mMap->getTileSize();
+	sf::Vector2i grid	   = mMap->getGridSize();
+
+	if (pos.x < 0 || pos.y < 0)
+	{
+		return -1;
+	}
+
+	int x = pos.x / tile_size.x;
+	int y = pos.y / tile_size.y;
+	if (x >= grid.x || y >= grid.y)
 	{
-		// If the mouse is hovered over a building
-		//& the right mouse button is released..
-		if (i->spr.getGlobalBounds().contains(
-				(sf::Vector2f)KeyManager::getMousePos()) &&
-			KeyManager::getRMouseState() == 1)
+		return -1;
+	}
+	return x + y * grid.x;
+}
+
+int &BuildingManager::getOccupant(unsigned tile)
+{
+	return mOccupancy[mLayout.index(tile)];
+}
+
+bool BuildingManager::canPlace(BuildingID id, unsigned tile)
+{
+	const BuildingStats &stats = mStats[id];
+	sf::Vector2i grid		   = mMap->getGridSize();
+
+	// The whole footprint has to fit on the map.
+	if ((int)(tile % grid.x) + stats.footprint.x > grid.x ||
+		(int)(tile / grid.x) + stats.footprint.y > grid.y)
+	{
+		return false;
+	}
+
+	// Check every covered tile.
+	for (sf::Vector2i offset : stats.cells)
+	{
+		unsigned covered = tile + offset.y * grid.x + offset.x;
+		int tile_id		 = mMap->getTileIDAt(covered);
+		if (tile_id < 0 || tile_id >= (int)stats.canbuildon.size() ||
+			!stats.canbuildon[tile_id] || getOccupant(covered) != -1)
 		{
-			// Remove the building from the map.
-			mBuilt.erase(i);
+			return false;
+		}
+	}
+	return true;
+}
+
+void BuildingManager::markOverlayDirty(unsigned tile)
+{
+	sf::Vector2i grid = mMap->getGridSize();
+	int x			  = tile % grid.x;
+	int y			  = tile / grid.x;
+
+	// Buildings above & left of the tile may cover it, so their chunks too.
+	int left   = std::max(x - mMaxFootprint.x + 1, 0) / CHUNK_SIZE;
+	int top	   = std::max(y - mMaxFootprint.y + 1, 0) / CHUNK_SIZE;
+	for (int cy = top; cy <= y / CHUNK_SIZE; ++cy)
+	{
+		for (int cx = left; cx <= x / CHUNK_SIZE; ++cx)
+		{
+			mOverlayChunkDirty[cy * mChunkCount.x + cx] = true;
+		}
+	}
+
+	// What can be pasted may have changed too.
+	mPasteDirty = true;
+}
 
-			// Return the sell price of the building.
-			for (auto &j : i->building_data->at("sellprice"))
+void BuildingManager::updateOverlay()
+{
+	// A different building can be placed elsewhere, so every chunk is stale.
+	BuildingID id = getBuildingID(*mBuildingBuilding);
+	if ((int)id != mOverlayBuilding)
+	{
+		mOverlayBuilding = id;
+		mOverlayChunkDirty.assign(mOverlayChunks.size(), true);
+	}
+
+	// Get the range of chunks in view.
+	sf::Vector2i grid		= mMap->getGridSize();
+	sf::Vector2f tile_size	= mMap->getTileSize();
+	sf::Vector2f chunk_size = tile_size * (float)CHUNK_SIZE;
+	sf::FloatRect visible	= KeyManager::getMapArea();
+	int left   = std::max(0, (int)std::floor(visible.left / chunk_size.x));
+	int top	   = std::max(0, (int)std::floor(visible.top / chunk_size.y));
+	int right  = std::min(mChunkCount.x, (int)std::ceil((visible.left + visible.width) / chunk_size.x));
+	int bottom = std::min(mChunkCount.y, (int)std::ceil((visible.top + visible.height) / chunk_size.y));
+
+	// Free the overlay of chunks that left the view.
+	auto out_of_view = [&](unsigned chunk) {
+		int x = chunk % mChunkCount.x;
+		int y = chunk / mChunkCount.x;
+		if (x >= left && x < right && y >= top && y < bottom)
+		{
+			return false;
+		}
+		mOverlayChunks[chunk]	  = sf::VertexArray(sf::Quads);
+		mOverlayChunkDirty[chunk] = true;
+		return true;
+	};
+	mOverlayBuilt.erase(std::remove_if(mOverlayBuilt.begin(), mOverlayBuilt.end(), out_of_view),
+						mOverlayBuilt.end());
+
+	// Rebuild the dirty chunks in view.
+	sf::Color color = HIGHLIGHT.at("PLACEABLE");
+	for (int cy = top; cy < bottom; ++cy)
+	{
+		for (int cx = left; cx < right; ++cx)
+		{
+			unsigned chunk = cy * mChunkCount.x + cx;
+			if (!mOverlayChunkDirty[chunk])
+			{
+				continue;
+			}
+			mOverlayChunkDirty[chunk] = false;
+			if (std::find(mOverlayBuilt.begin(), mOverlayBuilt.end(), chunk) ==
+				mOverlayBuilt.end())
 			{
-				mMaterials.addResources(
-					{.name  = j.at("name").get<std::string>(),
-					 .count = j.at("count").get<long>()});
+				mOverlayBuilt.push_back(chunk);
 			}
 
-			// Break.
-			break;
+			sf::VertexArray &quads = mOverlayChunks[chunk];
+			quads.clear();
+
+			// Add a quad for every placeable tile in the chunk.
+			for (int y = cy * CHUNK_SIZE; y < std::min((cy + 1) * CHUNK_SIZE, grid.y); ++y)
+			{
+				for (int x = cx * CHUNK_SIZE; x < std::min((cx + 1) * CHUNK_SIZE, grid.x); ++x)
+				{
+					if (!canPlace(id, y * grid.x + x))
+					{
+						continue;
+					}
+
+					sf::Vector2f pos(x * tile_size.x, y * tile_size.y);
+					quads.append(sf::Vertex(pos, color));
+					quads.append(sf::Vertex(pos + sf::Vector2f(tile_size.x, 0), color));
+					quads.append(sf::Vertex(pos + tile_size, color));
+					quads.append(sf::Vertex(pos + sf::Vector2f(0, tile_size.y), color));
+				}
+			}
+			mChanged = true;
 		}
-		else
+	}
+}
+
+void BuildingManager::addBuilt(BuildingID id,
+							   const std::vector<unsigned> &tiles)
+{
+	mBuilt.reserve(mBuilt.size() + tiles.size());
+	for (unsigned tile : tiles)
+	{
+		// Reserve every tile the building covers.
+		forFootprint(id, tile, [&](unsigned covered) {
+			getOccupant(covered) = mBuilt.size();
+			markOverlayDirty(covered);
+			if (mMinimap)
+			{
+				mMinimap->markChanged(covered);
+			}
+		});
+		mBuilt.push_back({.id = id, .tile = tile, .multiplier = Fixed(1)});
+
+		// Count it near its neighbours, & count its neighbours for it.
+		spreadInfluence(mBuilt.size() - 1, 1);
+		if (!mStats[id].bonuses.empty())
 		{
-			++i;
+			updateMultiplier(mBuilt.size() - 1);
 		}
+
+		// Its sprite is drawn from the top left.
+		mChunkBuilder.setTile(tile, id);
 	}
+
+	mBuiltCounts[id] += tiles.size();
+	mChanged = true;
+}
+
+std::vector<unsigned> BuildingManager::getPlaceableTiles(BuildingID id,
+														 sf::IntRect region)
+{
+	sf::Vector2i grid	   = mMap->getGridSize();
+	sf::Vector2i footprint = mStats[id].footprint;
+
+	std::vector<unsigned> tiles;
+	for (int y = region.top; y < std::min(region.top + region.height, grid.y);
+		 y += footprint.y)
+	{
+		for (int x = region.left;
+			 x < std::min(region.left + region.width, grid.x);
+			 x += footprint.x)
+		{
+			if (x < 0 || y < 0)
+			{
+				continue;
+			}
+
+			unsigned tile = y * grid.x + x;
+			if (canPlace(id, tile))
+			{
+				tiles.push_back(tile);
+			}
+		}
+	}
+	return tiles;
+}
+
+MaterialManager::Cost
+BuildingManager::getTotalPrice(const std::vector<unsigned> &counts)
+{
+	MaterialManager::Cost total;
+	for (BuildingID id = 0; id < counts.size(); ++id)
+	{
+		if (counts[id] == 0)
+		{
+			continue;
+		}
+
+		// Merge into the entry for each resource, so it's checked in full.
+		for (auto &i : mStats[id].price.get())
+		{
+			BigNumber count = i.count * BigNumber((long long)counts[id]);
+			auto found		= std::find_if(total.begin(), total.end(),
+									   [&](const MaterialManager::ResourceAmount &r) {
+										   return r.id == i.id;
+									   });
+			if (found == total.end())
+			{
+				total.push_back({.id = i.id, .count = count});
+			}
+			else
+			{
+				found->count += count;
+			}
+		}
+	}
+	return total;
+}
+
+unsigned BuildingManager::getAffordableCount(BuildingID id, unsigned count)
+{
+	// Limited by whichever resource runs out first.
+	for (auto &i : mStats[id].price.get())
+	{
+		if (i.count <= BigNumber(0))
+		{
+			continue;
+		}
+
+		BigNumber most = mMaterials.getResourceCount(i.id) / i.count;
+		if (most < BigNumber(count))
+		{
+			count = most <= BigNumber(0) ? 0 : most.toLong();
+		}
+	}
+	return count;
+}
+
+void BuildingManager::removeBuilt(const std::vector<unsigned> &indices)
+{
+	if (indices.empty())
+	{
+		return;
+	}
+
+	// Visit the removed buildings in index order.
+	std::vector<unsigned> removed = indices;
+	std::sort(removed.begin(), removed.end());
+	removed.erase(std::unique(removed.begin(), removed.end()), removed.end());
+
+	// Clear each removed building off the map.
+	for (unsigned index : removed)
+	{
+		BuildingEntityData &building = mBuilt[index];
+		mBuiltCounts[building.id]--;
+
+		// Take it off its neighbours' counts, while it's still on the grid.
+		spreadInfluence(index, -1);
+
+		// Free every tile it covered.
+		forFootprint(building.id, building.tile, [&](unsigned covered) {
+			getOccupant(covered) = -1;
+			markOverlayDirty(covered);
+			if (mMinimap)
+			{
+				mMinimap->markChanged(covered);
+			}
+		});
+		mChunkBuilder.setTile(building.tile, -1);
+	}
+
+	// Slide the survivors down over the gaps, in one pass. Those before the
+	// first gap keep their index, so only the moved ones are re-pointed.
+	unsigned kept = removed.front();
+	auto next	  = removed.begin();
+	for (unsigned i = removed.front(); i < mBuilt.size(); ++i)
+	{
+		if (next != removed.end() && *next == i)
+		{
+			++next;
+			continue;
+		}
+		mBuilt[kept] = mBuilt[i];
+		forFootprint(mBuilt[kept].id, mBuilt[kept].tile, [&](unsigned covered) {
+			getOccupant(covered) = kept;
+		});
+		kept++;
+	}
+	mBuilt.resize(kept);
+
+	mChanged = true;
+}
+
+unsigned BuildingManager::getInfluence(BuildingID from, int radius)
+{
+	for (unsigned i = 0; i < mInfluences.size(); ++i)
+	{
+		if (mInfluences[i].from == from && mInfluences[i].radius == radius)
+		{
+			return i;
+		}
+	}
+
+	// New fields start out empty, as nothing is built yet.
+	mInfluences.push_back({.from   = from,
+						   .radius = radius,
+						   .counts = std::vector<unsigned>(mLayout.getStorageSize(), 0)});
+	mStats[from].influences.push_back(mInfluences.size() - 1);
+	return mInfluences.size() - 1;
+}
+
+void BuildingManager::spreadInfluence(unsigned building, int delta)
+{
+	const BuildingEntityData &placed = mBuilt[building];
+	const BuildingStats &stats		 = mStats[placed.id];
+	sf::Vector2i grid				 = mMap->getGridSize();
+	sf::Vector2i pos(placed.tile % grid.x, placed.tile / grid.x);
+
+	for (unsigned field : stats.influences)
+	{
+		Influence &influence = mInfluences[field];
+		int radius			 = influence.radius;
+		sf::IntRect box(pos.x - radius,
+						pos.y - radius,
+						stats.footprint.x + radius * 2,
+						stats.footprint.y + radius * 2);
+
+		// Update the count over the box, & the buildings whose top left is in
+		// it.
+		mLayout.forRect(box, [&](sf::Vector2i tile, unsigned index) {
+			influence.counts[index] += delta;
+
+			int other = mOccupancy[index];
+			if (other != -1 && mBuilt[other].tile == (unsigned)(tile.y * grid.x + tile.x) &&
+				!mStats[mBuilt[other].id].bonuses.empty())
+			{
+				updateMultiplier(other);
+			}
+		});
+	}
+}
+
+void BuildingManager::updateMultiplier(unsigned building)
+{
+	BuildingEntityData &built = mBuilt[building];
+	unsigned index			  = mLayout.index(built.tile);
+
+	Fixed multiplier(1);
+	for (const Bonus &bonus : mStats[built.id].bonuses)
+	{
+		const Influence &influence = mInfluences[bonus.field];
+		unsigned count			   = influence.counts[index];
+
+		// A building doesn't boost itself.
+		if (influence.from == built.id && count > 0)
+		{
+			count--;
+		}
+		multiplier += bonus.per * Fixed((long long)std::min(count, bonus.max));
+	}
+	built.multiplier = multiplier;
+}
+
+sf::IntRect BuildingManager::getDragRegion(sf::Vector2i a, sf::Vector2i b)
+{
+	return sf::IntRect(std::min(a.x, b.x),
+					   std::min(a.y, b.y),
+					   std::abs(a.x - b.x) + 1,
+					   std::abs(a.y - b.y) + 1);
+}
+
+void BuildingManager::updateSelling()
+{
+	sf::Vector2f tile_size = mMap->getTileSize();
+	sf::Vector2f mouse	   = KeyManager::getMapMousePos();
+	bool mouseInBounds	   = getTileIndex(mouse) != -1;
+
+	// Track the hovered tile, keeping the last one while off the map.
+	if (mouseInBounds)
+	{
+		mSellEnd = sf::Vector2i(mouse.x / tile_size.x, mouse.y / tile_size.y);
+	}
+
+	// Start dragging out a region when the right mouse goes down on the map.
+	short rmb = KeyManager::getRMouseState();
+	if (rmb == 1 && !mSelling && mouseInBounds)
+	{
+		mSelling   = true;
+		mSellStart = mSellEnd;
+	}
+
+	if (!mSelling)
+	{
+		return;
+	}
+
+	// Cover the region being sold.
+	sf::IntRect region = getDragRegion(mSellStart, mSellEnd);
+	mSellRect.setPosition(region.left * tile_size.x, region.top * tile_size.y);
+	mSellRect.setSize(sf::Vector2f(region.width * tile_size.x,
+								   region.height * tile_size.y));
+	mChanged = true;
+
+	// Sell when the right mouse is released.
+	if (rmb == 2)
+	{
+		mSelling = false;
+		sellRegion(region);
+	}
+}
+
+void BuildingManager::sellRegion(sf::IntRect region)
+{
+	// Find the buildings in the region through the occupancy grid.
+	std::vector<unsigned> indices;
+	mLayout.forRect(region, [&](sf::Vector2i, unsigned index) {
+		int building = mOccupancy[index];
+		if (building != -1)
+		{
+			indices.push_back(building);
+		}
+	});
+
+	if (indices.empty())
+	{
+		return;
+	}
+
+	// A building covering several tiles is found once per tile.
+	std::sort(indices.begin(), indices.end());
+	indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+	// Count each type.
+	std::vector<unsigned> sold(mBuildings.size(), 0);
+	for (unsigned i : indices)
+	{
+		sold[mBuilt[i].id]++;
+	}
+
+	// Refund the summed sell prices in one transaction.
+	MaterialManager::Cost refund;
+	for (BuildingID id = 0; id < sold.size(); ++id)
+	{
+		if (sold[id] == 0)
+		{
+			continue;
+		}
+		for (auto &i : mStats[id].sellprice.get())
+		{
+			refund.push_back(
+				{.id = i.id, .count = i.count * BigNumber((long long)sold[id])});
+		}
+	}
+	mMaterials.addResources(refund);
+
+	// Remove the buildings from the map.
+	removeBuilt(indices);
 }
 
 void BuildingManager::updateTick()
@@ -368,98 +976,172 @@ void BuildingManager::updateTick()
 	// Update the per-tick MaterialManager resource logger.
 	mMaterials.updateResourceLogger();
 
+	// Expire any timed modifiers that ran out.
+	mTickCount++;
+	if (mNextExpiry != 0 && mTickCount >= mNextExpiry)
+	{
+		expireModifiers();
+	}
+
 	// For every built building...
 	for (auto &i : mBuilt)
 	{
 		// Get the pertick data.
-		nlohmann::json pertick = i.building_data->at("pertick");
-
-		// Get the resources per tick in & out.
-		nlohmann::json rpt_in  = pertick.at("resource_in");
-		nlohmann::json rpt_out = pertick.at("resource_out");
+		BuildingStats &stats = mStats[i.id];
 
-		bool purchaseable = true;
-		// Check to make sure the per-tick cost in can be paid.
-		for (auto &obj : rpt_in)
+		// Extractors stop once the tiles under them run out.
+		int source = -1;
+		if (stats.extracts != 0)
 		{
-			// Break if unpurchaseable.
-			if (!mMaterials.canPurchase(
-					{.name  = obj.at("name").get<std::string>(),
-					 .count = obj.at("count").get<int>()}))
+			source = getExtractTile(i);
+			if (source == -1)
 			{
-				purchaseable = false;
-				break;
+				continue;
 			}
 		}
 
-		// If the item is still purcheaseable...
-		if (purchaseable)
+		// Pay the per-tick cost in, if it can be paid...
+		if (!mMaterials.purchase(stats.resource_in.get()))
 		{
-			// Purchase it.
-			for (auto &obj : rpt_in)
-			{
-				mMaterials.purchase({.name  = obj.at("name").get<std::string>(),
-									 .count = obj.at("count").get<int>()});
-			}
+			continue;
+		}
+		if (source != -1)
+		{
+			mMap->extract(source, stats.extracts, mConversions);
+		}
 
-			// Get the amount of resources needed.
-			for (auto &obj : rpt_out)
+		// ...and produce the resources out, scaled by its neighbours' bonus.
+		if (i.multiplier == Fixed(1))
+		{
+			mMaterials.addResources(stats.resource_out.get());
+		}
+		else
+		{
+			mScaledOutput = stats.resource_out.get();
+			for (auto &r : mScaledOutput)
 			{
-				mMaterials.addResources(
-					{.name  = obj.at("name").get<std::string>(),
-					 .count = obj.at("count").get<int>()});
+				r.count = r.count * i.multiplier;
 			}
+			mMaterials.addResources(mScaledOutput);
 		}
 	}
+
+	// Convert every tile emptied this tick in one batch, so only their
+	// chunks are redrawn.
+	if (!mConversions.empty())
+	{
+		mMap->applyEdits(mConversions);
+		mConversions.clear();
+	}
 }
 
-int BuildingManager::getBuildingCount(std::string building_name)
+int BuildingManager::getExtractTile(const BuildingEntityData &building)
 {
-	// Return var (count).
-	int ret = 0;
+	int source = -1;
+	forFootprint(building.id, building.tile, [&](unsigned tile) {
+		if (source == -1 && mMap->getAmountAt(tile) != 0)
+		{
+			source = tile;
+		}
+	});
+	return source;
+}
 
-	// For every built structure...
-	for (auto &i : mBuilt)
+void BuildingManager::expireModifiers()
+{
+	mTPS.expire(mTickCount);
+	mNextExpiry = mTPS.getNextExpiry();
+
+	// Keep the earliest expiry out of every stat.
+	auto keep_next = [&](const ModifiedCost &cost) {
+		unsigned long long next = cost.getNextExpiry();
+		if (next != 0 && (mNextExpiry == 0 || next < mNextExpiry))
+		{
+			mNextExpiry = next;
+		}
+	};
+
+	for (auto &i : mStats)
 	{
-		// If the names match...
-		if (i.building_data->at("name").get<std::string>() == building_name)
+		for (ModifiedCost *cost :
+			 {&i.price, &i.sellprice, &i.resource_in, &i.resource_out})
 		{
-			// Increment ret;
-			ret++;
+			cost->expire(mTickCount);
+			keep_next(*cost);
 		}
 	}
 
-	// Return.
-	return ret;
+	// Expired price modifiers change affordability & tooltips.
+	refreshPrices();
+	for (BuildingID i = 0; i < mTooltips.size(); ++i)
+	{
+		invalidateTooltip(i);
+	}
+}
+
+void BuildingManager::refreshPrices()
+{
+	for (auto &i : mStats)
+	{
+		mMaterials.setPurchasableCost(i.purchasable, i.price.get());
+	}
+	mPasteDirty = true;
+}
+
+int BuildingManager::getBuildingCount(std::string building_name)
+{
+	return mBuiltCounts[getBuildingID(building_name)];
 }
 
 BuildingManager::Building *BuildingManager::getBuilding(std::string building_name)
 {
-	for (int i = 0; i < mBuildings; ++i)
+	for (auto &b : mBuildings)
 	{
-		Building *b = &mBuildings[i];
-		if (b->at("name").get<std::string>() == building_name)
+		if (b.at("name").get<std::string>() == building_name)
 		{
-			//
-			return b;
+			return &b;
 		}
 	}
 	return nullptr;
 }
 
+BuildingManager::BuildingID BuildingManager::getBuildingID(std::string building_name)
+{
+	Building *b = getBuilding(building_name);
+	if (b == nullptr)
+	{
+		throw std::out_of_range("Building " + building_name + " not found.");
+	}
+	return getBuildingID(*b);
+}
+
+BuildingManager::BuildingID BuildingManager::getBuildingID(const Building &building)
+{
+	return &building - mBuildings.data();
+}
+
 void BuildingManager::placeBuilding(BuildingManager::Building *building)
 {
-	mBuildMode = true;
-	mBuildingSprite.setTexture(*getBuildingTexture(*building));
+	mBuildMode	   = true;
+	mBlueprintMode = BlueprintMode::None;
+	mDragging	   = false;
+	mBuildingSprite.setTexture(mAtlas->getTexture());
+	mBuildingSprite.setTextureRect(getBuildingSprite(*building).getTextureRect());
 	mBuildingBuilding = building;
+
+	// Stretch the held sprite over the building's footprint.
+	sf::IntRect rect	   = mBuildingSprite.getTextureRect();
+	sf::Vector2f tile_size = mMap->getTileSize();
+	sf::Vector2i footprint = mStats[getBuildingID(*building)].footprint;
+	mBuildingSprite.setScale(footprint.x * tile_size.x / rect.width,
+							 footprint.y * tile_size.y / rect.height);
 }
 
 void BuildingManager::updateBuilding()
 {
 	bool mouseInBounds = true;
 	// If off the tilemap boundaries...
-	if (KeyManager::getMousePos().x > 800 || KeyManager::getMousePos().x < 0 ||
-		KeyManager::getMousePos().y > 560 || KeyManager::getMousePos().y < 0)
+	if (getTileIndex(KeyManager::getMapMousePos()) == -1)
 	{
 		mouseInBounds = false;
 	}
@@ -474,111 +1156,90 @@ void BuildingManager::updateBuilding()
 		return;
 	}
 
+	// Bring the placement overlay up to date.
+	if (mBuildMode)
+	{
+		updateOverlay();
+	}
+
 	// Get the mouse's highlighted tile position.
+	sf::Vector2f tile_size = mMap->getTileSize();
 	sf::Vector2f tile_pos =
-		mMap->getTileInside((sf::Vector2f)KeyManager::getMousePos());
-
-	// Get the data for the tile we're currently on.
-	nlohmann::json tiledata =
-		mMap->getTileDataFor(mMap->getTileID(tile_pos));
+		mMap->getTileInside(KeyManager::getMapMousePos());
 
 	// Place building sprite on the tile position.
 	mBuildingSprite.setPosition(tile_pos);
 	mHighlightRect.setPosition(tile_pos);
+	mHighlightRect.setSize(tile_size);
 
 	mHighlightRect.setFillColor(HIGHLIGHT.at("DEFAULT"));
 
-	//If not in build mode, return.
-	if (!mBuildMode || !mouseInBounds)
+	//If not in build mode, return. Drags continue off the map, so they can
+	//still be released there.
+	if (!mBuildMode || (!mouseInBounds && !mDragging))
 	{
 		return;
 	}
 
-	// Check if we can purchase the building.////////
-	bool purchaseable = true;
-	for (auto &i : mBuildingBuilding->at("price"))
+	// Track the hovered tile, keeping the last one while off the map.
+	if (mouseInBounds)
 	{
-		if (!mMaterials.canPurchase(
-				{.name  = i.at("name").get<std::string>(),
-				 .count = i.at("count").get<int>()}))
-		{
-			purchaseable = false;
-			break;
-		}
+		mDragEnd = sf::Vector2i(tile_pos.x / tile_size.x,
+								tile_pos.y / tile_size.y);
 	}
-	//Check if we can place the building/////////////
-	bool placeable = false;
 
-	// Release & return if we cannot place on this tile.
-	for (auto &i : mBuildingBuilding->at("canbuildon")
-					   .get<std::vector<std::string>>())
+	// Start dragging out a region when the left mouse goes down.
+	short lmb = KeyManager::getLMouseState();
+	if (lmb == 1 && !mDragging)
 	{
-		// Get the tile's name.
-		std::string tile_name = tiledata.at("name").get<std::string>();
-
-		// If the name matches the tile, the tile is placeable.
-		if (tile_name == i)
-		{
-			placeable = true;
-			break;
-		}
-	}
-	// Assert the building's position is not taken up.
-	for (auto &i : mBuilt)
-	{
-		// If it is..
-		if (i.spr.getGlobalBounds().contains(tile_pos))
-		{
-			//it's not placeable..
-			placeable = false;
-			break;
-		}
+		mDragging  = true;
+		mDragStart = mDragEnd;
 	}
 
-	// If not purchaseable, or not placeable...
-	if (!purchaseable || !placeable)
+	// The dragged region, or just the hovered tile, rounded up to whole
+	// footprints.
+	BuildingID id		   = getBuildingID(*mBuildingBuilding);
+	sf::Vector2i footprint = mStats[id].footprint;
+	sf::IntRect region =
+		getDragRegion(mDragging ? mDragStart : mDragEnd, mDragEnd);
+	region.width  = (region.width + footprint.x - 1) / footprint.x * footprint.x;
+	region.height = (region.height + footprint.y - 1) / footprint.y * footprint.y;
+
+	// Validate the whole region, & see how much of it can be bought.
+	std::vector<unsigned> tiles = getPlaceableTiles(id, region);
+	unsigned affordable			= getAffordableCount(id, tiles.size());
+
+	// Cover the region, in red if nothing would be placed.
+	mHighlightRect.setPosition(region.left * tile_size.x,
+							   region.top * tile_size.y);
+	mHighlightRect.setSize(sf::Vector2f(region.width * tile_size.x,
+										region.height * tile_size.y));
+	if (affordable == 0)
 	{
-		//Highlight the tile red...
 		mHighlightRect.setFillColor(HIGHLIGHT.at("INVALID"));
 	}
 
-	// Check if left mouse is clicked.
-	if (KeyManager::getLMouseState() == 1)
+	// Place when the left mouse is released.
+	if (lmb == 2 && mDragging)
 	{
-		//If we're not in bounds...
-		if (!mouseInBounds)
-		{
-			//Release & return.
-			releaseBuilding();
-			return;
-		}   //THIS CHECK MAY BE REDUNDANT, BUT I GOT SCARED SO I LEFT IT HERE
-
-		//If we can't place the building...
-		if (!placeable)
-		{
-			// Release & return.
-			releaseBuilding();
-			return;
-		}
+		mDragging = false;
 
-		// If purchaseable...
-		if (purchaseable)
+		// Fill the region row by row, as far as the money goes.
+		tiles.resize(affordable);
+		if (!tiles.empty())
 		{
-			// Purchase...
-			for (auto &i : mBuildingBuilding->at("price"))
+			// Pay for everything in one transaction.
+			MaterialManager::Cost total = mStats[id].price.get();
+			for (auto &i : total)
 			{
-				mMaterials.purchase({.name  = i.at("name").get<std::string>(),
-									 .count = i.at("count").get<int>()});
+				i.count = i.count * BigNumber((long long)tiles.size());
 			}
 
-			// Plant the building.
-			BuildingEntityData b;
-			b.building_data = mBuildingBuilding;
-			b.spr.setTexture(*getBuildingTexture(*mBuildingBuilding));
-			b.spr.setPosition(tile_pos);
-
-			//..Why does this line error in vs code, but compile properly??
-			mBuilt.push_back(b);
+			// Plant the buildings, unless the payment fell through.
+			if (mMaterials.purchase(total))
+			{
+				addBuilt(id, tiles);
+			}
 		}
 
 		// Release the building.
@@ -588,6 +1249,7 @@ void BuildingManager::updateBuilding()
 
 void BuildingManager::releaseBuilding()
 {
+	mDragging = false;
 	if (KeyManager::getKeyState(sf::Keyboard::LShift) == 0)
 		mBuildMode = false;
 }
@@ -612,12 +1274,16 @@ bool BuildingManager::initBuildings()
 	mObjectData = object_data;
 
 	// Init the material manager.
-	mMaterials.initResources(object_data);
+	mMaterials.initResources(object_data, *mAtlas);
 
 	// Get the base texture directory
 	std::string texture_dir =
 		"resource/objects/" + object_data.at("texturedir").get<std::string>();
 
+	// The name of tile ID 0, which getTileIDFromName() returns if not found.
+	std::string air_name =
+		mMap->getTileDataFor(0).at("name").get<std::string>();
+
 	// Iterate through the list of buildings.
 	for (nlohmann::json &obj :
 		 object_data.at("buildings").get<nlohmann::json>())
@@ -629,36 +1295,172 @@ bool BuildingManager::initBuildings()
 
 		mBuildings.push_back(obj);
 
-		mBuildingTextures[obj.at("name").get<std::string>()].loadFromFile(tex);
+		// Resolve the numeric stats once, up front.
+		BuildingStats stats;
+		stats.price		   = ModifiedCost(mMaterials.priceToCost(obj.at("price")));
+		stats.sellprice	   = ModifiedCost(mMaterials.priceToCost(obj.at("sellprice")));
+		stats.resource_in  = ModifiedCost(mMaterials.priceToCost(obj.at("pertick").at("resource_in")));
+		stats.resource_out = ModifiedCost(mMaterials.priceToCost(obj.at("pertick").at("resource_out")));
+		stats.purchasable  = mMaterials.addPurchasable(stats.price.get());
+
+		// Compile the placeable tile names into a mask over tile IDs.
+		stats.canbuildon.assign(mMap->getTileTypeCount(), false);
+		for (auto &i : obj.at("canbuildon"))
+		{
+			std::string tile = i.get<std::string>();
+			int tile_id		 = mMap->getTileIDFromName(tile);
+
+			// Unknown names come back as air.
+			if (tile_id == 0 && tile != air_name)
+			{
+				throw std::runtime_error("Building " +
+										 obj.at("name").get<std::string>() +
+										 " -- unknown tile " + tile);
+			}
+			stats.canbuildon[tile_id] = true;
+		}
+
+		// Extractors say how much they take from their tiles per tick.
+		auto extracts  = obj.find("extracts");
+		stats.extracts = extracts == obj.end() ? 0 : extracts->get<unsigned>();
+
+		// Read the footprint, a single tile if not given.
+		stats.footprint = {1, 1};
+		stats.cells		= {{0, 0}};
+		auto footprint	= obj.find("footprint");
+		if (footprint != obj.end())
+		{
+			parseFootprint(obj.at("name").get<std::string>(), *footprint, stats);
+		}
+		mMaxFootprint.x = std::max(mMaxFootprint.x, stats.footprint.x);
+		mMaxFootprint.y = std::max(mMaxFootprint.y, stats.footprint.y);
+
+		mStats.push_back(stats);
+		mBuiltCounts.push_back(0);
+
+		// Format the parts of the tooltip that never change.
+		BuildingTooltip tooltip;
+		tooltip.name  = obj.at("name").get<std::string>();
+		tooltip.dirty = true;
+		for (auto &i : obj.at("description"))
+		{
+			tooltip.description.push_back(i.get<std::string>());
+		}
+		for (auto &i : obj.at("canbuildon"))
+		{
+			std::string tile = i.get<std::string>();
+			tooltip.canbuildon.push_back({.icon = mMap->getTileSprite(tile),
+										  .text = tile});
+		}
+		mTooltips.push_back(tooltip);
+
+		mBuildingSprites.push_back(mAtlas->getSprite(tex));
 	}
 
 	// Return successful.
 	return true;
 }
 
-sf::Texture *BuildingManager::getBuildingTexture(std::string building_name)
+void BuildingManager::initBonuses()
 {
-	// Search for the texture...
-	auto found = std::find_if(
-		mBuildings.begin(), mBuildings.end(), [&](Building &b) -> bool {
-			return b.at("name").get<std::string>() == building_name;
-		});
+	nlohmann::json &buildings = mObjectData.at("buildings");
+	for (BuildingID id = 0; id < buildings.size(); ++id)
+	{
+		auto bonuses = buildings[id].find("bonuses");
+		if (bonuses == buildings[id].end())
+		{
+			continue;
+		}
+
+		for (auto &i : *bonuses)
+		{
+			// Throws if the building doesn't exist.
+			BuildingID from = getBuildingID(i.at("from").get<std::string>());
+			int radius		= i.at("radius").get<int>();
+			if (radius < 0)
+			{
+				throw std::runtime_error("Building " +
+										 buildings[id].at("name").get<std::string>() +
+										 " -- bonus radius can't be negative");
+			}
+
+			// With no max, every neighbour counts.
+			auto max = i.find("max");
+			mStats[id].bonuses.push_back(
+				{.field = getInfluence(from, radius),
+				 .per	= i.at("per").get<Fixed>(),
+				 .max	= max == i.end() ? std::numeric_limits<unsigned>::max()
+										 : max->get<unsigned>()});
+		}
+	}
+}
 
-	// Throw if not found.
-	if (found == mBuildings.end())
+void BuildingManager::parseFootprint(const std::string &name,
+									 const nlohmann::json &data,
+									 BuildingStats &stats)
+{
+	stats.footprint = {data.at("size").at(0).get<int>(),
+					   data.at("size").at(1).get<int>()};
+	if (stats.footprint.x < 1 || stats.footprint.y < 1)
+	{
+		throw std::runtime_error("Building " + name +
+								 " -- footprint must be at least 1x1");
+	}
+
+	// Without a mask, the whole box is covered.
+	stats.cells.clear();
+	auto mask = data.find("mask");
+	if (mask == data.end())
+	{
+		for (int y = 0; y < stats.footprint.y; ++y)
+		{
+			for (int x = 0; x < stats.footprint.x; ++x)
+			{
+				stats.cells.push_back({x, y});
+			}
+		}
+		return;
+	}
+
+	// Otherwise, one string per row, with '.' for an uncovered tile.
+	if ((int)mask->size() != stats.footprint.y)
 	{
-		throw std::out_of_range("getBuildingTexture() -- building not found.");
+		throw std::runtime_error("Building " + name +
+								 " -- footprint mask needs one row per tile");
+	}
+	for (int y = 0; y < stats.footprint.y; ++y)
+	{
+		std::string row = mask->at(y).get<std::string>();
+		if ((int)row.size() != stats.footprint.x)
+		{
+			throw std::runtime_error("Building " + name +
+									 " -- footprint mask row is the wrong width");
+		}
+		for (int x = 0; x < stats.footprint.x; ++x)
+		{
+			if (row[x] != '.')
+			{
+				stats.cells.push_back({x, y});
+			}
+		}
 	}
 
-	// Return the building texture.
-	return &mBuildingTextures[found->at("name").get<std::string>()];
+	// The top left tile anchors the building, so must be covered.
+	if (stats.cells.empty() || stats.cells[0] != sf::Vector2i(0, 0))
+	{
+		throw std::runtime_error("Building " + name +
+								 " -- footprint must cover its top left tile");
+	}
 }
 
-sf::Texture *
-BuildingManager::getBuildingTexture(BuildingManager::Building &building)
+const sf::Sprite &BuildingManager::getBuildingSprite(std::string building_name)
 {
-	// Get the name & return the corresponding texture.
-	std::string name = building.at("name").get<std::string>();
+	// Throws if the building isn't found.
+	return mBuildingSprites[getBuildingID(building_name)];
+}
 
-	return &mBuildingTextures[name];
+const sf::Sprite &
+BuildingManager::getBuildingSprite(BuildingManager::Building &building)
+{
+	return mBuildingSprites[getBuildingID(building)];
 }
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "BuildingManager.hpp"
+
+#include <filesystem>
+
+void BuildingManager::renderGuiBlueprints()
+{
+	//Start copying, by dragging out a region of buildings.
+	if (ImGui::Button("Copy"))
+	{
+		mBuildMode	   = false;
+		mDragging	   = false;
+		mBlueprintMode = BlueprintMode::Capture;
+	}
+
+	//Pick the blueprint up again.
+	if (!mBlueprint.empty() && ImGui::Button("Paste"))
+	{
+		mBuildMode	   = false;
+		mDragging	   = false;
+		mBlueprintMode = BlueprintMode::Paste;
+		mPasteDirty	   = true;
+	}
+
+	if (ImGui::Button("Save"))
+	{
+		if (mBlueprint.empty())
+		{
+			mBlueprintStatus = "Nothing to save.";
+		}
+		else
+		{
+			mBlueprintStatus = saveBlueprint() ? "Saved." : "Save failed.";
+		}
+	}
+
+	if (ImGui::Button("Load"))
+	{
+		mBlueprintStatus = loadBlueprint() ? "Loaded." : "Load failed.";
+	}
+
+	//What the mouse is doing.
+	switch (mBlueprintMode)
+	{
+	case BlueprintMode::Capture:
+		ImGui::Text("Drag to copy.");
+		break;
+	case BlueprintMode::Paste:
+		ImGui::Text("Click to paste.");
+		break;
+	case BlueprintMode::None:
+	default:
+		ImGui::Text("%s", mBlueprintStatus.c_str());
+		break;
+	}
+}
+
+void BuildingManager::updateBlueprint()
+{
+	if (mBlueprintMode == BlueprintMode::None)
+	{
+		return;
+	}
+
+	// Escape puts the blueprint down.
+	if (KeyManager::getKeyState(sf::Keyboard::Escape))
+	{
+		mBlueprintMode = BlueprintMode::None;
+		mDragging	   = false;
+		return;
+	}
+
+	sf::Vector2f tile_size = mMap->getTileSize();
+	sf::Vector2f mouse	   = KeyManager::getMapMousePos();
+	bool mouseInBounds	   = getTileIndex(mouse) != -1;
+
+	// Track the hovered tile, keeping the last one while off the map.
+	if (mouseInBounds)
+	{
+		mDragEnd = sf::Vector2i(mouse.x / tile_size.x, mouse.y / tile_size.y);
+	}
+	else if (!mDragging)
+	{
+		return;
+	}
+
+	short lmb = KeyManager::getLMouseState();
+
+	// Capturing: drag out the region to copy.
+	if (mBlueprintMode == BlueprintMode::Capture)
+	{
+		if (lmb == 1 && !mDragging)
+		{
+			mDragging  = true;
+			mDragStart = mDragEnd;
+		}
+
+		sf::IntRect region =
+			getDragRegion(mDragging ? mDragStart : mDragEnd, mDragEnd);
+		mHighlightRect.setPosition(region.left * tile_size.x,
+								   region.top * tile_size.y);
+		mHighlightRect.setSize(sf::Vector2f(region.width * tile_size.x,
+											region.height * tile_size.y));
+
+		// Copy on release, & hold the copy to paste.
+		if (lmb == 2 && mDragging)
+		{
+			mDragging = false;
+			captureBlueprint(region);
+			mBlueprintMode =
+				mBlueprint.empty() ? BlueprintMode::None : BlueprintMode::Paste;
+			mPasteDirty = true;
+		}
+		return;
+	}
+
+	// Pasting: the blueprint's top left follows the mouse.
+	if (mPasteDirty || mDragEnd != mPasteAnchor)
+	{
+		validatePaste(mDragEnd);
+		mChanged = true;
+	}
+
+	mHighlightRect.setPosition(mPasteAnchor.x * tile_size.x,
+							   mPasteAnchor.y * tile_size.y);
+	mHighlightRect.setSize(sf::Vector2f(mPasteSize.x * tile_size.x,
+										mPasteSize.y * tile_size.y));
+
+	bool affordable = mMaterials.canPurchase(mPastePrice);
+	if (!affordable)
+	{
+		mHighlightRect.setFillColor(HIGHLIGHT.at("INVALID"));
+	}
+
+	// Paste on click, keeping hold of the blueprint to stamp again.
+	if (lmb == 2 && mouseInBounds && affordable)
+	{
+		pasteBlueprint();
+	}
+}
+
+void BuildingManager::captureBlueprint(sf::IntRect region)
+{
+	sf::Vector2i grid = mMap->getGridSize();
+
+	// Find every building whose top left is in the region, row by row.
+	std::vector<Blueprint::Cell> found;
+	sf::Vector2i first = {region.left + region.width, region.top + region.height};
+	for (int y = std::max(region.top, 0);
+		 y < std::min(region.top + region.height, grid.y);
+		 ++y)
+	{
+		for (int x = std::max(region.left, 0);
+			 x < std::min(region.left + region.width, grid.x);
+			 ++x)
+		{
+			unsigned tile = y * grid.x + x;
+			int building  = getOccupant(tile);
+			if (building == -1 || mBuilt[building].tile != tile)
+			{
+				continue;
+			}
+			found.push_back({.offset = sf::Vector2i(x, y),
+							 .building = mBuilt[building].id});
+			first.x = std::min(first.x, x);
+			first.y = std::min(first.y, y);
+		}
+	}
+
+	// Store them relative to the top left building, trimming empty margins.
+	mBlueprint = Blueprint();
+	for (auto &i : found)
+	{
+		mBlueprint.addCell(i.offset - first, i.building);
+	}
+}
+
+void BuildingManager::validatePaste(sf::Vector2i anchor)
+{
+	mPasteAnchor = anchor;
+	mPasteDirty	 = false;
+
+	const std::vector<Blueprint::Cell> &cells = mBlueprint.getCells();
+	sf::Vector2i grid						  = mMap->getGridSize();
+	sf::Vector2f tile_size					  = mMap->getTileSize();
+
+	// Check every cell against the map, the tile masks & occupancy. Cells
+	// from a file may overlap, so the first to claim a tile keeps it.
+	std::vector<unsigned> counts(mBuildings.size(), 0);
+	mPasteClaimed.clear();
+	mPasteTiles.resize(cells.size());
+	mPasteSize = {0, 0};
+	for (unsigned i = 0; i < cells.size(); ++i)
+	{
+		BuildingID id	 = cells[i].building;
+		sf::Vector2i pos = anchor + cells[i].offset;
+		unsigned tile	 = pos.y * grid.x + pos.x;
+		bool placeable	 = pos.x < grid.x && pos.y < grid.y && canPlace(id, tile);
+		if (placeable)
+		{
+			forFootprint(id, tile, [&](unsigned covered) {
+				placeable = placeable && mPasteClaimed.count(covered) == 0;
+			});
+		}
+
+		mPasteTiles[i] = placeable ? tile : -1;
+		if (placeable)
+		{
+			forFootprint(id, tile, [&](unsigned covered) {
+				mPasteClaimed.insert(covered);
+			});
+			counts[id]++;
+		}
+
+		// Grow the highlight over the cell's footprint.
+		sf::Vector2i footprint = mStats[id].footprint;
+		mPasteSize.x = std::max(mPasteSize.x, cells[i].offset.x + footprint.x);
+		mPasteSize.y = std::max(mPasteSize.y, cells[i].offset.y + footprint.y);
+	}
+	mPastePrice = getTotalPrice(counts);
+
+	// Rebuild the ghost, tinting the cells that won't be placed.
+	mGhost.setPrimitiveType(sf::Quads);
+	mGhost.resize(cells.size() * 4);
+	for (unsigned i = 0; i < cells.size(); ++i)
+	{
+		sf::Vertex *quad   = &mGhost[i * 4];
+		sf::Vector2f pos   = {(anchor.x + cells[i].offset.x) * tile_size.x,
+							  (anchor.y + cells[i].offset.y) * tile_size.y};
+		sf::Vector2i foot  = mStats[cells[i].building].footprint;
+		sf::Vector2f size  = {foot.x * tile_size.x, foot.y * tile_size.y};
+		sf::FloatRect tex  = (sf::FloatRect)mBuildingSprites[cells[i].building]
+								.getTextureRect();
+		sf::Color color	   = mPasteTiles[i] == -1 ? sf::Color(255, 80, 80, 150)
+												  : sf::Color(255, 255, 255, 150);
+
+		quad[0].position = pos;
+		quad[1].position = pos + sf::Vector2f(size.x, 0);
+		quad[2].position = pos + size;
+		quad[3].position = pos + sf::Vector2f(0, size.y);
+
+		quad[0].texCoords = sf::Vector2f(tex.left, tex.top);
+		quad[1].texCoords = sf::Vector2f(tex.left + tex.width, tex.top);
+		quad[2].texCoords = sf::Vector2f(tex.left + tex.width, tex.top + tex.height);
+		quad[3].texCoords = sf::Vector2f(tex.left, tex.top + tex.height);
+
+		for (int v = 0; v < 4; ++v)
+		{
+			quad[v].color = color;
+		}
+	}
+}
+
+bool BuildingManager::pasteBlueprint()
+{
+	// Pay for every placeable cell at once.
+	if (!mMaterials.purchase(mPastePrice))
+	{
+		return false;
+	}
+
+	// Place them, one batch per building type.
+	const std::vector<Blueprint::Cell> &cells = mBlueprint.getCells();
+	std::vector<std::vector<unsigned>> tiles(mBuildings.size());
+	for (unsigned i = 0; i < cells.size(); ++i)
+	{
+		if (mPasteTiles[i] != -1)
+		{
+			tiles[cells[i].building].push_back(mPasteTiles[i]);
+		}
+	}
+
+	bool placed = false;
+	for (BuildingID id = 0; id < tiles.size(); ++id)
+	{
+		if (!tiles[id].empty())
+		{
+			addBuilt(id, tiles[id]);
+			placed = true;
+		}
+	}
+	return placed;
+}
+
+bool BuildingManager::saveBlueprint()
+{
+	std::vector<std::string> names;
+	for (auto &i : mBuildings)
+	{
+		names.push_back(i.at("name").get<std::string>());
+	}
+
+	// Make sure the folder exists.
+	std::error_code error;
+	std::filesystem::create_directories(
+		std::filesystem::path(BLUEPRINT_PATH).parent_path(), error);
+
+	std::ofstream file(BLUEPRINT_PATH);
+	if (!file)
+	{
+		return false;
+	}
+	file << mBlueprint.toJson(names).dump(1, '\t');
+
+	return (bool)file;
+}
+
+bool BuildingManager::loadBlueprint()
+{
+	std::ifstream file(BLUEPRINT_PATH);
+	if (!file)
+	{
+		return false;
+	}
+
+	// A bad file shouldn't take the game down with it.
+	try
+	{
+		nlohmann::json data;
+		file >> data;
+		mBlueprint = Blueprint::fromJson(data, [this](const std::string &name) {
+			return getBuildingID(name);
+		});
+	}
+	catch (const std::exception &)
+	{
+		return false;
+	}
+
+	mPasteDirty = true;
+	return true;
+}
@@ -0,0 +1,196 @@
+#include "ChunkBuilder.hpp"
+
+ChunkBuilder::ChunkBuilder()
+{
+	mStop = false;
+}
+
+ChunkBuilder::~ChunkBuilder()
+{
+	// Wake the worker to stop it.
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWake.notify_one();
+
+	if (mThread.joinable())
+	{
+		mThread.join();
+	}
+}
+
+void ChunkBuilder::init(sf::Vector2i grid,
+						sf::Vector2f tile_size,
+						int chunk_size,
+						std::vector<sf::IntRect> sprites,
+						std::vector<sf::Vector2i> footprints)
+{
+	mGrid		= grid;
+	mTileSize	= tile_size;
+	mChunkSize	= chunk_size;
+	mChunkCount = {(grid.x + chunk_size - 1) / chunk_size,
+				   (grid.y + chunk_size - 1) / chunk_size};
+	mSprites	= sprites;
+	mFootprints = footprints;
+
+	mChunkSprites.assign(mChunkCount.x * mChunkCount.y, {});
+	mChunkDirty.assign(mChunkSprites.size(), false);
+	mFront.assign(mChunkCount.x * mChunkCount.y, sf::VertexArray(sf::Quads));
+
+	mThread = std::thread(&ChunkBuilder::run, this);
+}
+
+void ChunkBuilder::setTile(unsigned tile, int sprite)
+{
+	mPending.push_back({tile, sprite});
+}
+
+void ChunkBuilder::flush()
+{
+	if (mPending.empty())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQueue.insert(mQueue.end(), mPending.begin(), mPending.end());
+	}
+	mPending.clear();
+	mWake.notify_one();
+}
+
+bool ChunkBuilder::collect()
+{
+	std::vector<std::pair<unsigned, sf::VertexArray>> ready;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		ready.swap(mReady);
+	}
+
+	// Swap the new buffers in.
+	for (auto &i : ready)
+	{
+		mFront[i.first] = std::move(i.second);
+	}
+	return !ready.empty();
+}
+
+const std::vector<sf::VertexArray> &ChunkBuilder::getChunks() const
+{
+	return mFront;
+}
+
+void ChunkBuilder::run()
+{
+	std::vector<std::pair<unsigned, int>> edits;
+	std::vector<unsigned> dirty;
+
+	while (true)
+	{
+		// Wait for edits, or to be stopped.
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [this] { return mStop || !mQueue.empty(); });
+			if (mStop)
+			{
+				return;
+			}
+			edits.swap(mQueue);
+		}
+
+		// Apply the edits, noting which chunks they touched.
+		dirty.clear();
+		for (auto &i : edits)
+		{
+			unsigned chunk = applyEdit(i);
+			if (!mChunkDirty[chunk])
+			{
+				mChunkDirty[chunk] = true;
+				dirty.push_back(chunk);
+			}
+		}
+		edits.clear();
+
+		// Build each touched chunk into a back buffer.
+		std::vector<std::pair<unsigned, sf::VertexArray>> built;
+		for (unsigned chunk : dirty)
+		{
+			mChunkDirty[chunk] = false;
+			built.push_back({chunk, sf::VertexArray(sf::Quads)});
+			buildChunk(chunk, built.back().second);
+		}
+
+		// Publish them, replacing any older uncollected builds.
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (auto &i : built)
+		{
+			auto found = std::find_if(mReady.begin(), mReady.end(), [&](auto &r) {
+				return r.first == i.first;
+			});
+			if (found != mReady.end())
+			{
+				found->second = std::move(i.second);
+			}
+			else
+			{
+				mReady.push_back(std::move(i));
+			}
+		}
+	}
+}
+
+unsigned ChunkBuilder::applyEdit(std::pair<unsigned, int> edit)
+{
+	unsigned chunk = (edit.first % mGrid.x) / mChunkSize +
+					 (edit.first / mGrid.x) / mChunkSize * mChunkCount.x;
+	std::vector<std::pair<unsigned, int>> &sprites = mChunkSprites[chunk];
+
+	// Replace or remove the tile's entry, or add one.
+	auto found = std::find_if(sprites.begin(), sprites.end(), [&](auto &i) {
+		return i.first == edit.first;
+	});
+	if (found == sprites.end())
+	{
+		if (edit.second != -1)
+		{
+			sprites.push_back(edit);
+		}
+	}
+	else if (edit.second == -1)
+	{
+		*found = sprites.back();
+		sprites.pop_back();
+	}
+	else
+	{
+		found->second = edit.second;
+	}
+	return chunk;
+}
+
+void ChunkBuilder::buildChunk(unsigned chunk, sf::VertexArray &out)
+{
+	// Append a quad for every sprite in the chunk.
+	for (auto &i : mChunkSprites[chunk])
+	{
+		int x	   = i.first % mGrid.x;
+		int y	   = i.first / mGrid.x;
+		int sprite = i.second;
+
+		// Stretch the sprite over its whole footprint.
+		sf::FloatRect tex = (sf::FloatRect)mSprites[sprite];
+		sf::Vector2f pos  = {x * mTileSize.x, y * mTileSize.y};
+		sf::Vector2f size = {mFootprints[sprite].x * mTileSize.x,
+							 mFootprints[sprite].y * mTileSize.y};
+
+		out.append(sf::Vertex(pos, {tex.left, tex.top}));
+		out.append(sf::Vertex(pos + sf::Vector2f(size.x, 0),
+							  {tex.left + tex.width, tex.top}));
+		out.append(sf::Vertex(pos + size,
+							  {tex.left + tex.width, tex.top + tex.height}));
+		out.append(sf::Vertex(pos + sf::Vector2f(0, size.y),
+							  {tex.left, tex.top + tex.height}));
+	}
+}
@@ -0,0 +1,358 @@
+#include "Fixed.hpp"
+
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+__extension__ typedef __int128 int128;
+__extension__ typedef unsigned __int128 uint128;
+
+// The raw value of 1.0, and of 0.5 for rounding.
+const int64_t ONE  = (int64_t)1 << Fixed::FRACTION_BITS;
+const int64_t HALF = ONE >> 1;
+
+// Mask of the fractional bits.
+const uint64_t FRACTION_MASK = (uint64_t)ONE - 1;
+
+// The limits of BigNumber's storage.
+const uint128 BIG_MAX = (uint128)BigNumber::max().raw();
+
+/**
+ * @brief Clamp a wide intermediate back into the 64-bit raw range.
+ *
+ */
+int64_t saturate(int128 v)
+{
+	if (v > (int128)INT64_MAX)
+	{
+		return INT64_MAX;
+	}
+	if (v < (int128)INT64_MIN)
+	{
+		return INT64_MIN;
+	}
+	return (int64_t)v;
+}
+
+/**
+ * @brief Apply a sign to an unsigned magnitude, saturating into a BigNumber.
+ *
+ */
+BigNumber signedBig(uint128 mag, bool negative)
+{
+	if (mag > BIG_MAX)
+	{
+		return negative ? BigNumber::min() : BigNumber::max();
+	}
+	return BigNumber::fromRaw(negative ? -(int128)mag : (int128)mag);
+}
+
+/**
+ * @brief Magnitude of a 128-bit value, safe for the minimum value.
+ *
+ */
+uint128 magnitude(int128 v)
+{
+	return (v < 0) ? -(uint128)v : (uint128)v;
+}
+}
+
+Fixed::Fixed()
+	: mRaw(0)
+{
+}
+
+Fixed::Fixed(long long whole)
+	: mRaw(saturate((int128)whole * ONE))
+{
+}
+
+Fixed Fixed::fromRaw(int64_t raw)
+{
+	Fixed ret;
+	ret.mRaw = raw;
+	return ret;
+}
+
+Fixed Fixed::fromDouble(double value)
+{
+	if (std::isnan(value))
+	{
+		return Fixed();
+	}
+
+	// Scale up & round to the nearest representable step.
+	double scaled = std::round(std::ldexp(value, FRACTION_BITS));
+	if (scaled >= 9.2e18)
+	{
+		return fromRaw(INT64_MAX);
+	}
+	if (scaled <= -9.2e18)
+	{
+		return fromRaw(INT64_MIN);
+	}
+	return fromRaw((int64_t)scaled);
+}
+
+Fixed Fixed::fromString(const std::string &str)
+{
+	size_t i	  = 0;
+	bool negative = false;
+
+	// Handle the sign.
+	if (i < str.size() && (str[i] == '-' || str[i] == '+'))
+	{
+		negative = str[i] == '-';
+		++i;
+	}
+
+	// Accumulate the whole part.
+	int128 whole = 0;
+	bool digits	 = false;
+	for (; i < str.size() && str[i] != '.'; ++i)
+	{
+		if (str[i] < '0' || str[i] > '9')
+		{
+			throw std::invalid_argument("Fixed -- invalid digit in " + str);
+		}
+		whole  = std::min<int128>(whole * 10 + (str[i] - '0'), INT64_MAX);
+		digits = true;
+	}
+
+	// Accumulate up to 18 fractional digits as numerator / 10^n.
+	int128 num = 0, den = 1;
+	if (i < str.size() && str[i] == '.')
+	{
+		for (++i; i < str.size(); ++i)
+		{
+			if (str[i] < '0' || str[i] > '9')
+			{
+				throw std::invalid_argument("Fixed -- invalid digit in " + str);
+			}
+			if (den < (int128)1000000000000000000LL)
+			{
+				num = num * 10 + (str[i] - '0');
+				den *= 10;
+			}
+			digits = true;
+		}
+	}
+
+	if (!digits)
+	{
+		throw std::invalid_argument("Fixed -- no digits in " + str);
+	}
+
+	// Combine, rounding the fraction to the nearest step.
+	int128 raw = whole * ONE + ((num << FRACTION_BITS) + den / 2) / den;
+	return fromRaw(saturate(negative ? -raw : raw));
+}
+
+int64_t Fixed::raw() const
+{
+	return mRaw;
+}
+
+double Fixed::toDouble() const
+{
+	return std::ldexp((double)mRaw, -FRACTION_BITS);
+}
+
+BigNumber Fixed::round() const
+{
+	uint128 mag = magnitude(mRaw);
+	return signedBig((mag + HALF) >> FRACTION_BITS, mRaw < 0);
+}
+
+Fixed &Fixed::operator+=(const Fixed &rhs)
+{
+	mRaw = saturate((int128)mRaw + rhs.mRaw);
+	return *this;
+}
+
+Fixed &Fixed::operator-=(const Fixed &rhs)
+{
+	mRaw = saturate((int128)mRaw - rhs.mRaw);
+	return *this;
+}
+
+Fixed &Fixed::operator*=(const Fixed &rhs)
+{
+	// The full product fits in 128 bits, round off the extra fraction.
+	uint128 mag = magnitude((int128)mRaw * rhs.mRaw);
+	mag			= (mag + HALF) >> FRACTION_BITS;
+
+	// At most 2^94 after the shift, so it fits back into a signed int128.
+	bool negative = (mRaw < 0) != (rhs.mRaw < 0);
+	mRaw		  = saturate(negative ? -(int128)mag : (int128)mag);
+	return *this;
+}
+
+Fixed &Fixed::operator/=(const Fixed &rhs)
+{
+	// Division by zero saturates.
+	if (rhs.mRaw == 0)
+	{
+		mRaw = (mRaw < 0) ? INT64_MIN : (mRaw > 0) ? INT64_MAX : 0;
+		return *this;
+	}
+
+	mRaw = saturate(((int128)mRaw * ONE) / rhs.mRaw);
+	return *this;
+}
+
+Fixed operator+(Fixed lhs, const Fixed &rhs)
+{
+	return lhs += rhs;
+}
+
+Fixed operator-(Fixed lhs, const Fixed &rhs)
+{
+	return lhs -= rhs;
+}
+
+Fixed operator*(Fixed lhs, const Fixed &rhs)
+{
+	return lhs *= rhs;
+}
+
+Fixed operator/(Fixed lhs, const Fixed &rhs)
+{
+	return lhs /= rhs;
+}
+
+bool operator==(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw == rhs.mRaw;
+}
+
+bool operator!=(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw != rhs.mRaw;
+}
+
+bool operator<(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw < rhs.mRaw;
+}
+
+bool operator>(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw > rhs.mRaw;
+}
+
+bool operator<=(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw <= rhs.mRaw;
+}
+
+bool operator>=(const Fixed &lhs, const Fixed &rhs)
+{
+	return lhs.mRaw >= rhs.mRaw;
+}
+
+BigNumber operator*(const BigNumber &lhs, const Fixed &rhs)
+{
+	uint128 v = magnitude(lhs.raw());
+	uint128 r = magnitude(rhs.raw());
+
+	// Split the count so neither partial product can overflow:
+	// v * r / 2^32 = hi * r + lo * r / 2^32
+	uint128 hi = v >> Fixed::FRACTION_BITS;
+	uint128 lo = v & FRACTION_MASK;
+
+	bool negative = (lhs.raw() < 0) != (rhs.raw() < 0);
+
+	uint128 high_part;
+	if (__builtin_mul_overflow(hi, r, &high_part))
+	{
+		return negative ? BigNumber::min() : BigNumber::max();
+	}
+	uint128 low_part = (lo * r + HALF) >> Fixed::FRACTION_BITS;
+
+	uint128 total;
+	if (__builtin_add_overflow(high_part, low_part, &total))
+	{
+		return negative ? BigNumber::min() : BigNumber::max();
+	}
+
+	return signedBig(total, negative);
+}
+
+BigNumber operator/(const BigNumber &lhs, const Fixed &rhs)
+{
+	bool negative = (lhs.raw() < 0) != (rhs.raw() < 0);
+
+	// Division by zero saturates.
+	if (rhs.raw() == 0)
+	{
+		return (lhs.raw() == 0) ? BigNumber()
+								: negative ? BigNumber::min() : BigNumber::max();
+	}
+
+	uint128 v = magnitude(lhs.raw());
+	uint128 r = magnitude(rhs.raw());
+
+	// v * 2^32 / r = q * 2^32 + rem * 2^32 / r
+	uint128 q	= v / r;
+	uint128 rem = v % r;
+
+	if (q > (BIG_MAX >> Fixed::FRACTION_BITS))
+	{
+		return negative ? BigNumber::min() : BigNumber::max();
+	}
+
+	uint128 total = (q << Fixed::FRACTION_BITS) +
+					((rem << Fixed::FRACTION_BITS) + r / 2) / r;
+
+	return signedBig(total, negative);
+}
+
+void to_json(nlohmann::json &j, const Fixed &f)
+{
+	uint128 mag		  = magnitude(f.raw());
+	uint64_t fraction = (uint64_t)(mag & FRACTION_MASK);
+
+	// Whole values are plain integers.
+	if (fraction == 0)
+	{
+		j = (long long)(f.raw() >> Fixed::FRACTION_BITS);
+		return;
+	}
+
+	// Otherwise, write out the decimal digits of the fraction. 2^-32 has
+	// exactly 32 of them, so this always terminates & is exact.
+	std::string str = (f.raw() < 0) ? "-" : "";
+	str += std::to_string((unsigned long long)(mag >> Fixed::FRACTION_BITS));
+	str += ".";
+	while (fraction != 0)
+	{
+		fraction *= 10;
+		str.push_back('0' + (char)(fraction >> Fixed::FRACTION_BITS));
+		fraction &= FRACTION_MASK;
+	}
+
+	j = str;
+}
+
+void from_json(const nlohmann::json &j, Fixed &f)
+{
+	if (j.is_number_integer())
+	{
+		f = Fixed(j.get<long long>());
+	}
+	else if (j.is_number_float())
+	{
+		f = Fixed::fromDouble(j.get<double>());
+	}
+	else if (j.is_string())
+	{
+		f = Fixed::fromString(j.get<std::string>());
+	}
+	else
+	{
+		throw std::invalid_argument("Fixed -- json value is not a number.");
+	}
+}
@@ -0,0 +1,33 @@
+#include "GridLayout.hpp"
+
+GridLayout::GridLayout()
+	: GridLayout(sf::Vector2i(0, 0))
+{
+}
+
+GridLayout::GridLayout(sf::Vector2i size)
+{
+	mSize		= size;
+	mChunkCount = {(size.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+				   (size.y + CHUNK_SIZE - 1) / CHUNK_SIZE};
+}
+
+sf::Vector2i GridLayout::getSize() const
+{
+	return mSize;
+}
+
+sf::Vector2i GridLayout::getChunkCount() const
+{
+	return mChunkCount;
+}
+
+unsigned GridLayout::getStorageSize() const
+{
+	return mChunkCount.x * mChunkCount.y * CHUNK_TILES;
+}
+
+bool GridLayout::contains(sf::Vector2i pos) const
+{
+	return pos.x >= 0 && pos.y >= 0 && pos.x < mSize.x && pos.y < mSize.y;
+}
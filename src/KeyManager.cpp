@@ -2,89 +2,141 @@
 
 // STATIC DECL
 sf::RenderWindow *KeyManager::mWindowPtr;
-std::unordered_map<sf::Keyboard::Key, short> KeyManager::mKeyStates;
-short KeyManager::mLMouseState;
-short KeyManager::mRMouseState;
+std::bitset<sf::Keyboard::KeyCount> KeyManager::mKeysDown;
+std::bitset<sf::Keyboard::KeyCount> KeyManager::mKeysPendingRelease;
+std::bitset<sf::Keyboard::KeyCount> KeyManager::mKeysReleased;
+std::bitset<sf::Mouse::ButtonCount> KeyManager::mButtonsDown;
+std::bitset<sf::Mouse::ButtonCount> KeyManager::mButtonsPendingRelease;
+std::bitset<sf::Mouse::ButtonCount> KeyManager::mButtonsReleased;
+sf::Vector2i KeyManager::mPendingMousePos;
+sf::Vector2i KeyManager::mMousePos;
+const sf::View *KeyManager::mMapView;
+sf::Vector2f KeyManager::mMapMousePos;
 /////////////
 
 void KeyManager::setWindowReference(sf::RenderWindow *newPtr)
 {
 	mWindowPtr = newPtr;
+
+	// Take the starting mouse position, until the first move event.
+	mPendingMousePos = sf::Mouse::getPosition(*mWindowPtr);
+	mMousePos		 = mPendingMousePos;
 }
 
-void KeyManager::update()
+void KeyManager::handleEvent(const sf::Event &event)
 {
-	// For every key supported by SFML...
-	for (unsigned i = 0; i < (unsigned)sf::Keyboard::KeyCount; ++i)
+	switch (event.type)
 	{
-		// Temporary variable for the current key.
-		sf::Keyboard::Key cKey = static_cast<sf::Keyboard::Key>(i);
-
-		// If it's pressed, set it's state to pressed.
-		if (sf::Keyboard::isKeyPressed(cKey))
+	default:
+		break;
+	case sf::Event::KeyPressed:
+		// Ignore keys SFML doesn't know.
+		if (event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount)
 		{
-			mKeyStates[cKey] = 1;
+			mKeysDown.set(event.key.code);
 		}
-		else
+		break;
+	case sf::Event::KeyReleased:
+		if (event.key.code >= 0 && event.key.code < sf::Keyboard::KeyCount)
 		{
-			// If it's not pressed, and was just pressed,
-			//..it was just released.
-			if (mKeyStates[cKey] == 1)
-			{
-				mKeyStates[cKey] = 2;
-			}
-			// Otherwise, it's unpressed.
-			else
-				mKeyStates[cKey] = 0;
+			mKeysDown.reset(event.key.code);
+			mKeysPendingRelease.set(event.key.code);
 		}
+		break;
+	case sf::Event::MouseButtonPressed:
+		mButtonsDown.set(event.mouseButton.button);
+		break;
+	case sf::Event::MouseButtonReleased:
+		mButtonsDown.reset(event.mouseButton.button);
+		mButtonsPendingRelease.set(event.mouseButton.button);
+		break;
+	case sf::Event::MouseMoved:
+		mPendingMousePos = {event.mouseMove.x, event.mouseMove.y};
+		break;
+	case sf::Event::LostFocus:
+		// Release events won't arrive while unfocused, so release everything.
+		mKeysPendingRelease |= mKeysDown;
+		mKeysDown.reset();
+		mButtonsPendingRelease |= mButtonsDown;
+		mButtonsDown.reset();
+		break;
 	}
+}
 
-	// Mouse position updates!
-	// If the mouse is pressed, set state to 1.
-	if (sf::Mouse::isButtonPressed(sf::Mouse::Left))
-	{
-		mLMouseState = 1;
-	}
-	else
-	{
-		// Set the mouse state to just released if it was pressed..
-		// Otherwise, set it to unpressed.
-		mLMouseState = (mLMouseState == 1) ? (2) : (0);
-	}
+void KeyManager::update()
+{
+	// Publish this frame's releases, & start collecting the next frame's.
+	mKeysReleased = mKeysPendingRelease;
+	mKeysPendingRelease.reset();
+	mButtonsReleased = mButtonsPendingRelease;
+	mButtonsPendingRelease.reset();
 
-	// Repeat for the right mouse too.
-	// Mouse position updates!
-	// If the mouse is pressed, set state to 1.
-	if (sf::Mouse::isButtonPressed(sf::Mouse::Right))
+	// Snapshot the mouse position for this frame.
+	mMousePos = mPendingMousePos;
+
+	// Map it into the map's view, if it's over the map.
+	mMapMousePos = {-1, -1};
+	if (mMapView && mWindowPtr->getViewport(*mMapView).contains(mMousePos))
 	{
-		mRMouseState = 1;
+		mMapMousePos = mWindowPtr->mapPixelToCoords(mMousePos, *mMapView);
 	}
-	else
+}
+
+sf::Vector2i KeyManager::getMousePos()
+{
+	return mMousePos;
+}
+
+void KeyManager::setMapView(const sf::View *view)
+{
+	mMapView = view;
+}
+
+sf::Vector2f KeyManager::getMapMousePos()
+{
+	return mMapMousePos;
+}
+
+sf::FloatRect KeyManager::getMapArea()
+{
+	if (!mMapView)
 	{
-		// Set the mouse state to just released if it was pressed..
-		// Otherwise, set it to unpressed.
-		mRMouseState = (mRMouseState == 1) ? (2) : (0);
+		return sf::FloatRect();
 	}
+	return sf::FloatRect(mMapView->getCenter() - mMapView->getSize() / 2.0f,
+						 mMapView->getSize());
 }
 
-sf::Vector2i KeyManager::getMousePos()
+short KeyManager::getButtonState(sf::Mouse::Button button)
 {
-	// Get the mouse position relative to the current window.
-	return sf::Mouse::getPosition(*mWindowPtr);
+	// Held buttons are pressed, even if also released earlier this frame.
+	if (mButtonsDown.test(button))
+	{
+		return 1;
+	}
+	return mButtonsReleased.test(button) ? 2 : 0;
 }
 
 short KeyManager::getLMouseState()
 {
-	return mLMouseState;
+	return getButtonState(sf::Mouse::Left);
 }
 
 short KeyManager::getRMouseState()
 {
-	return mRMouseState;
+	return getButtonState(sf::Mouse::Right);
 }
 
 short KeyManager::getKeyState(sf::Keyboard::Key key)
 {
 	// Retrieve the state of the specified key.
-	return mKeyStates[key];
-}
\ No newline at end of file
+	if (key < 0 || key >= sf::Keyboard::KeyCount)
+	{
+		return 0;
+	}
+	if (mKeysDown.test(key))
+	{
+		return 1;
+	}
+	return mKeysReleased.test(key) ? 2 : 0;
+}
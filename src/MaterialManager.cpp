@@ -1,10 +1,13 @@
 #include "MaterialManager.hpp"
 
+#include <numeric>
+
 MaterialManager::MaterialManager()
 {
 }
 
-void MaterialManager::initResources(nlohmann::json &objectdata)
+void MaterialManager::initResources(nlohmann::json &objectdata,
+									const TextureAtlas &atlas)
 {
 	std::string texture_dir =
 		"resource/objects/" + objectdata.at("texturedir").get<std::string>();
@@ -13,53 +16,98 @@ void MaterialManager::initResources(nlohmann::json &objectdata)
 	for (nlohmann::json &obj :
 		 objectdata.at("resources").get<nlohmann::json>())
 	{
-		// Get its name, and add it to the mResources map.
+		// Get its name, and assign it the next ID.
 		std::string name = obj.at("name").get<std::string>();
 
-		mResources[name] = 0;
+		mIDs[name] = mNames.size();
+		mNames.push_back(name);
+		mCounts.push_back(0);
+		mFlushedCounts.push_back(0);
+		mIsChanged.push_back(false);
+		mPurchasablesByResource.push_back({});
 
-		// Init the icon texture directory.
-		mIconTextures[name] = sf::Texture();
-		mIconTextures[name].loadFromFile(texture_dir +
-										 obj.at("icon").get<std::string>());
+		// Find the icon in the atlas.
+		mIcons.push_back(
+			atlas.getSprite(texture_dir + obj.at("icon").get<std::string>()));
 
 		// Init the deque resourceLog
-		mResourceLog[name] = std::deque<float>();
+		mResourceLog.push_back(std::deque<BigNumber>());
 	}
 }
 
+MaterialManager::ResourceID
+MaterialManager::getResourceID(const std::string &resource_name) const
+{
+	auto found = mIDs.find(resource_name);
+	if (found == mIDs.end())
+	{
+		throw std::out_of_range("Resource " + resource_name + " not found.");
+	}
+	return found->second;
+}
+
+const std::string &MaterialManager::getResourceName(ResourceID id) const
+{
+	return mNames[id];
+}
+
+unsigned MaterialManager::getResourceTypeCount() const
+{
+	return mNames.size();
+}
+
 void MaterialManager::setResourceCount(MaterialManager::Resource r)
 {
 	// Set the new count of resources.
-	mResources[r.name] = r.count;
+	ResourceID id = getResourceID(r.name);
+	mCounts[id]	  = r.count;
+	markChanged(id);
+}
+
+BigNumber MaterialManager::getResourceCount(std::string resource_name)
+{
+	return mCounts[getResourceID(resource_name)];
 }
 
-int MaterialManager::getResourceCount(std::string resource_name)
+const BigNumber &MaterialManager::getResourceCount(ResourceID id) const
 {
-	return mResources[resource_name];
+	return mCounts[id];
 }
 
 void MaterialManager::addResources(MaterialManager::Resource r)
 {
 	// Add the specified resource count.
-	mResources[r.name] += r.count;
+	ResourceID id = getResourceID(r.name);
+	mCounts[id] += r.count;
+	markChanged(id);
+}
+
+void MaterialManager::addResources(const Cost &c)
+{
+	for (auto &i : c)
+	{
+		mCounts[i.id] += i.count;
+		markChanged(i.id);
+	}
 }
 
 void MaterialManager::removeResources(MaterialManager::Resource r)
 {
-	mResources[r.name] -= r.count;
+	ResourceID id = getResourceID(r.name);
+	mCounts[id] -= r.count;
+	markChanged(id);
 }
 
-std::vector<MaterialManager::Resource> MaterialManager::priceToResourceVector(
-	nlohmann::json::array_t price)
+MaterialManager::Cost
+MaterialManager::priceToCost(const nlohmann::json &price) const
 {
-	std::vector<Resource> ret;
+	Cost ret;
 
 	//Append each resource item.
 	for (auto &i : price)
 	{
-		ret.push_back({.name  = i.at("name").get<std::string>(),
-					   .count = i.at("count").get<long>()});
+		ret.push_back({.id	= getResourceID(i.at("name").get<std::string>()),
+					   .count = i.at("count").get<BigNumber>()});
 	}
 
 	//Return the resulting vector.
@@ -68,24 +116,21 @@ std::vector<MaterialManager::Resource> MaterialManager::priceToResourceVector(
 
 bool MaterialManager::canPurchase(MaterialManager::Resource r)
 {
-	return mResources[r.name] >= r.count;
+	return mCounts[getResourceID(r.name)] >= r.count;
 }
 
-bool MaterialManager::canPurchaseMultiple(std::vector<MaterialManager::Resource> r)
+bool MaterialManager::canPurchase(const Cost &c) const
 {
-	bool ret = true;
 	//For every resource...
-	for (auto &i : r)
+	for (auto &i : c)
 	{
-		//If any one of them isn't purcahseable...
-		if (!canPurchase(i))
+		//If any one of them isn't purcahseable, it's unpurchaseable.
+		if (mCounts[i.id] < i.count)
 		{
-			//..It's unpurchaseable.
-			ret = false;
-			break;
+			return false;
 		}
 	}
-	return ret;
+	return true;
 }
 
 bool MaterialManager::purchase(MaterialManager::Resource r)
@@ -96,37 +141,120 @@ bool MaterialManager::purchase(MaterialManager::Resource r)
 	}
 
 	// Purchase the item.
-	mResources[r.name] -= r.count;
+	ResourceID id = getResourceID(r.name);
+	mCounts[id] -= r.count;
+	markChanged(id);
 
 	// We were successful.
 	return true;
 }
 
-bool MaterialManager::purchaseMultiple(std::vector<MaterialManager::Resource> r)
+bool MaterialManager::purchase(const Cost &c)
 {
-	if (!canPurchaseMultiple(r))
+	if (!canPurchase(c))
 	{
 		return false;
 	}
 
 	//Purchase
-	for (auto &i : r)
+	for (auto &i : c)
 	{
-		mResources[i.name] -= i.count;
+		mCounts[i.id] -= i.count;
+		markChanged(i.id);
 	}
 
 	//Return successful.
 	return true;
 }
 
+MaterialManager::PurchasableID MaterialManager::addPurchasable(const Cost &c)
+{
+	PurchasableID id = mPurchasableCosts.size();
+	mPurchasableCosts.push_back(c);
+	mAffordable.push_back(canPurchase(c));
+	indexPurchasable(id, true);
+	return id;
+}
+
+void MaterialManager::setPurchasableCost(PurchasableID id, const Cost &c)
+{
+	indexPurchasable(id, false);
+	mPurchasableCosts[id] = c;
+	mAffordable[id]		  = canPurchase(c);
+	indexPurchasable(id, true);
+}
+
+bool MaterialManager::isAffordable(PurchasableID id) const
+{
+	return mAffordable[id];
+}
+
+void MaterialManager::indexPurchasable(PurchasableID id, bool add)
+{
+	for (auto &i : mPurchasableCosts[id])
+	{
+		std::vector<PurchasableID> &users = mPurchasablesByResource[i.id];
+		auto found = std::find(users.begin(), users.end(), id);
+		if (add && found == users.end())
+		{
+			users.push_back(id);
+		}
+		else if (!add && found != users.end())
+		{
+			users.erase(found);
+		}
+	}
+}
+
+void MaterialManager::addChangeListener(ChangeListener listener)
+{
+	mChangeListeners.push_back(listener);
+}
+
+void MaterialManager::markChanged(ResourceID id)
+{
+	if (!mIsChanged[id])
+	{
+		mIsChanged[id] = true;
+		mChanged.push_back(id);
+	}
+}
+
+void MaterialManager::flushChanges()
+{
+	for (ResourceID id : mChanged)
+	{
+		mIsChanged[id] = false;
+
+		// Skip resources that changed, then changed back.
+		if (mFlushedCounts[id] == mCounts[id])
+		{
+			continue;
+		}
+
+		// Recheck only the purchasables that use this resource.
+		for (PurchasableID p : mPurchasablesByResource[id])
+		{
+			mAffordable[p] = canPurchase(mPurchasableCosts[p]);
+		}
+
+		for (auto &listener : mChangeListeners)
+		{
+			listener(id, mFlushedCounts[id], mCounts[id]);
+		}
+		mFlushedCounts[id] = mCounts[id];
+	}
+	mChanged.clear();
+}
+
 void MaterialManager::updateResourceLogger()
 {
 	// Push the count of all resources back into the logger.
-	for (auto &i : mResources)
+	for (ResourceID i = 0; i < mCounts.size(); ++i)
 	{
-		std::deque<float> *queue = &(mResourceLog.find(i.first)->second);
+		std::deque<BigNumber> *queue = &mResourceLog[i];
 		// Push the current value.
-		queue->push_back(i.second);
+		queue->push_back(mCounts[i]);
 
 		// Pop the other end if the size is too large.
 		if (queue->size() > LOG_QUEUE_SIZE)
@@ -136,13 +264,13 @@ void MaterialManager::updateResourceLogger()
 	}
 }
 
-float MaterialManager::getAverageResourcePerTick(std::string resource)
+float MaterialManager::getAverageResourcePerTick(ResourceID id)
 {
 	// Get the queue of the specific resource.
-	std::deque<float> *queue = &(mResourceLog.find(resource)->second);
+	std::deque<BigNumber> *queue = &mResourceLog[id];
 
 	// Get the difference of all elements.
-	std::vector<float> queue_diff;
+	std::vector<BigNumber> queue_diff;
 
 	// Assert that elements are actually yknow, *in the queue*
 	if (queue->size() <= 1)
@@ -158,24 +286,18 @@ float MaterialManager::getAverageResourcePerTick(std::string resource)
 	}
 
 	// Return the average difference.
-	return std::accumulate(queue_diff.begin(), queue_diff.end(), 0.0f) /
+	return std::accumulate(queue_diff.begin(), queue_diff.end(), BigNumber())
+			   .toDouble() /
 		   (float)queue_diff.size();
 }
 
-const std::map<std::string, long> &MaterialManager::getResources()
+const sf::Sprite &MaterialManager::getIcon(std::string resource)
 {
-	return mResources;
+	// Assert the resource exists & return the icon.
+	return mIcons[getResourceID(resource)];
 }
 
-sf::Texture *MaterialManager::getTexture(std::string resource)
+const sf::Sprite &MaterialManager::getIcon(ResourceID id)
 {
-	// Assert the resource exists.
-	auto found = mIconTextures.find(resource);
-	if (found == mIconTextures.end())
-	{
-		throw std::out_of_range("Resource " + resource + " not found.");
-	}
-
-	// Return the texture.
-	return &(found->second);
-}
\ No newline at end of file
+	return mIcons[id];
+}
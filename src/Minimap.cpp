@@ -0,0 +1,154 @@
+#include "Minimap.hpp"
+
+Minimap::Minimap()
+{
+	mAllChanged = false;
+}
+
+void Minimap::init(sf::Vector2i grid,
+				   std::vector<sf::Color> ground_colors,
+				   std::vector<sf::Color> building_colors)
+{
+	mGrid			= grid;
+	mGroundColors	= ground_colors;
+	mBuildingColors = building_colors;
+
+	mPixels.assign(grid.x * grid.y * 4, 0);
+
+	mChunkCount = {(grid.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+				   (grid.y + CHUNK_SIZE - 1) / CHUNK_SIZE};
+	mDirtyRects.assign(mChunkCount.x * mChunkCount.y, sf::IntRect());
+	mDirtyChunks.clear();
+	mUpload.reserve(CHUNK_SIZE * CHUNK_SIZE * 4);
+
+	mTexture.create(grid.x, grid.y);
+	mTexture.update(mPixels.data());
+	mSprite.setTexture(mTexture, true);
+}
+
+void Minimap::setGroundSource(Source ground)
+{
+	mGround		= ground;
+	mAllChanged = true;
+}
+
+void Minimap::setBuildingSource(Source buildings)
+{
+	mBuildings	= buildings;
+	mAllChanged = true;
+}
+
+void Minimap::markChanged(unsigned tile)
+{
+	mChangedTiles.push_back(tile);
+}
+
+void Minimap::updatePixel(unsigned tile)
+{
+	int building = mBuildings ? mBuildings(tile) : -1;
+	int ground	 = mGround ? mGround(tile) : 0;
+
+	// Buildings cover the ground.
+	sf::Color color = sf::Color::Transparent;
+	if (building != -1)
+	{
+		color = mBuildingColors[building];
+	}
+	else if (ground >= 0 && ground < (int)mGroundColors.size())
+	{
+		color = mGroundColors[ground];
+	}
+
+	sf::Uint8 *pixel = &mPixels[tile * 4];
+	pixel[0]		 = color.r;
+	pixel[1]		 = color.g;
+	pixel[2]		 = color.b;
+	pixel[3]		 = color.a;
+}
+
+void Minimap::markDirty(unsigned tile)
+{
+	int x = tile % mGrid.x;
+	int y = tile / mGrid.x;
+
+	unsigned chunk	  = (y / CHUNK_SIZE) * mChunkCount.x + x / CHUNK_SIZE;
+	sf::IntRect &rect = mDirtyRects[chunk];
+	if (rect.width == 0)
+	{
+		rect = sf::IntRect(x, y, 1, 1);
+		mDirtyChunks.push_back(chunk);
+		return;
+	}
+
+	// Grow the area to contain the pixel.
+	int right	= std::max(rect.left + rect.width, x + 1);
+	int bottom	= std::max(rect.top + rect.height, y + 1);
+	rect.left	= std::min(rect.left, x);
+	rect.top	= std::min(rect.top, y);
+	rect.width	= right - rect.left;
+	rect.height = bottom - rect.top;
+}
+
+bool Minimap::update()
+{
+	// Recolor everything, & upload it in one go.
+	if (mAllChanged)
+	{
+		for (unsigned i = 0; i < (unsigned)(mGrid.x * mGrid.y); ++i)
+		{
+			updatePixel(i);
+		}
+		mTexture.update(mPixels.data());
+
+		for (unsigned chunk : mDirtyChunks)
+		{
+			mDirtyRects[chunk] = sf::IntRect();
+		}
+		mDirtyChunks.clear();
+		mChangedTiles.clear();
+		mAllChanged = false;
+		return true;
+	}
+
+	// Recolor the changed tiles, as the sources have them now.
+	for (unsigned i : mChangedTiles)
+	{
+		updatePixel(i);
+		markDirty(i);
+	}
+	mChangedTiles.clear();
+
+	if (mDirtyChunks.empty())
+	{
+		return false;
+	}
+
+	// Upload each chunk's dirty area in one call, packing its rows together.
+	for (unsigned chunk : mDirtyChunks)
+	{
+		sf::IntRect &rect = mDirtyRects[chunk];
+		mUpload.resize(rect.width * rect.height * 4);
+		for (int y = 0; y < rect.height; ++y)
+		{
+			std::copy_n(&mPixels[((rect.top + y) * mGrid.x + rect.left) * 4],
+						rect.width * 4,
+						&mUpload[y * rect.width * 4]);
+		}
+		mTexture.update(mUpload.data(), rect.width, rect.height, rect.left, rect.top);
+		rect = sf::IntRect();
+	}
+	mDirtyChunks.clear();
+
+	return true;
+}
+
+const sf::Texture &Minimap::getTexture() const
+{
+	return mTexture;
+}
+
+void Minimap::draw(sf::RenderTarget &target, sf::RenderStates states) const
+{
+	states.transform *= getTransform();
+	target.draw(mSprite, states);
+}
@@ -0,0 +1,159 @@
+#include "ModifiedStat.hpp"
+
+namespace
+{
+bool saturated(const BigNumber &value)
+{
+	return value == BigNumber::max() || value == BigNumber::min();
+}
+
+bool saturated(const Fixed &value)
+{
+	return value.raw() == INT64_MAX || value.raw() == INT64_MIN;
+}
+
+/**
+ * @brief Apply an operation count times, rounding after each step.
+ *
+ * @param op Returns op(value, operand), ex: the product.
+ */
+template <typename T, typename Op>
+void applyRepeated(T &value, const Fixed &operand, unsigned count, Op op)
+{
+	for (; count != 0 && !saturated(value); --count)
+	{
+		// Once a step leaves the value unchanged, so will every other.
+		T next = op(value, operand);
+		if (next == value)
+		{
+			return;
+		}
+		value = next;
+	}
+}
+}
+
+void applyModifier(BigNumber &value, const Modifier &mod)
+{
+	switch (mod.type)
+	{
+	case ModifierType::Add:
+		value += mod.value.round() * BigNumber(mod.count);
+		break;
+	case ModifierType::Multiply:
+		applyRepeated(value, mod.value, mod.count, [](const BigNumber &v, const Fixed &f) {
+			return v * f;
+		});
+		break;
+	case ModifierType::Divide:
+		applyRepeated(value, mod.value, mod.count, [](const BigNumber &v, const Fixed &f) {
+			return v / f;
+		});
+		break;
+	case ModifierType::Override:
+		value = mod.value.round();
+		break;
+	}
+}
+
+void applyModifier(Fixed &value, const Modifier &mod)
+{
+	switch (mod.type)
+	{
+	case ModifierType::Add:
+		value += mod.value * Fixed(mod.count);
+		break;
+	case ModifierType::Multiply:
+		applyRepeated(value, mod.value, mod.count, [](const Fixed &v, const Fixed &f) {
+			return v * f;
+		});
+		break;
+	case ModifierType::Divide:
+		applyRepeated(value, mod.value, mod.count, [](const Fixed &v, const Fixed &f) {
+			return v / f;
+		});
+		break;
+	case ModifierType::Override:
+		value = mod.value;
+		break;
+	}
+}
+
+ModifiedCost::ModifiedCost()
+	: mDirty(false)
+{
+}
+
+ModifiedCost::ModifiedCost(const MaterialManager::Cost &base)
+	: mBase(base), mCached(base), mDirty(false)
+{
+	for (auto &i : base)
+	{
+		mSlots.push_back(ModifiedStat<BigNumber>(i.count));
+	}
+}
+
+const MaterialManager::Cost &ModifiedCost::get() const
+{
+	if (mDirty)
+	{
+		for (unsigned i = 0; i < mSlots.size(); ++i)
+		{
+			mCached[i].count = mSlots[i].get();
+		}
+		mDirty = false;
+	}
+	return mCached;
+}
+
+const MaterialManager::Cost &ModifiedCost::getBase() const
+{
+	return mBase;
+}
+
+const ModifiedStat<BigNumber> &ModifiedCost::getSlot(unsigned slot) const
+{
+	return mSlots[slot];
+}
+
+void ModifiedCost::push(unsigned slot, const Modifier &mod)
+{
+	mSlots[slot].push(mod);
+	mDirty = true;
+}
+
+bool ModifiedCost::removeSource(unsigned source)
+{
+	bool removed = false;
+	for (auto &i : mSlots)
+	{
+		removed |= i.removeSource(source);
+	}
+	mDirty |= removed;
+	return removed;
+}
+
+bool ModifiedCost::expire(unsigned long long tick)
+{
+	bool removed = false;
+	for (auto &i : mSlots)
+	{
+		removed |= i.expire(tick);
+	}
+	mDirty |= removed;
+	return removed;
+}
+
+unsigned long long ModifiedCost::getNextExpiry() const
+{
+	unsigned long long ret = 0;
+	for (auto &i : mSlots)
+	{
+		unsigned long long next = i.getNextExpiry();
+		if (next != 0 && (ret == 0 || next < ret))
+		{
+			ret = next;
+		}
+	}
+	return ret;
+}
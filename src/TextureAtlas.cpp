@@ -0,0 +1,137 @@
+#include "TextureAtlas.hpp"
+
+TextureAtlas::TextureAtlas(std::vector<std::string> directories)
+{
+	namespace fs = std::filesystem;
+
+	// Load every image.
+	std::vector<std::pair<std::string, sf::Image>> images;
+	for (auto &dir : directories)
+	{
+		for (auto &entry : fs::recursive_directory_iterator(dir))
+		{
+			if (!entry.is_regular_file() || entry.path().extension() != ".png")
+			{
+				continue;
+			}
+
+			std::string path = normalize(entry.path().generic_string());
+			images.push_back({path, sf::Image()});
+			if (!images.back().second.loadFromFile(path))
+			{
+				throw std::runtime_error("Could not load " + path);
+			}
+		}
+	}
+
+	// Tallest first, so each shelf wastes little height.
+	std::sort(images.begin(), images.end(), [](auto &a, auto &b) {
+		return a.second.getSize().y > b.second.getSize().y;
+	});
+
+	// Start at a width that fits the total area as a square.
+	unsigned area = 0;
+	for (auto &i : images)
+	{
+		area += (i.second.getSize().x + PADDING) * (i.second.getSize().y + PADDING);
+	}
+	unsigned width = 64;
+	while (width * width < area)
+	{
+		width *= 2;
+	}
+
+	// Pack onto shelves, left to right & top to bottom.
+	unsigned x = 0, y = 0, shelf_height = 0;
+	for (auto &i : images)
+	{
+		sf::Vector2u size = i.second.getSize();
+
+		// Widen the atlas for images wider than it.
+		while (size.x > width)
+		{
+			width *= 2;
+		}
+
+		// Start a new shelf when this one is full.
+		if (x + size.x > width)
+		{
+			x = 0;
+			y += shelf_height + PADDING;
+			shelf_height = 0;
+		}
+
+		mRects[i.first] = sf::IntRect(x, y, size.x, size.y);
+		x += size.x + PADDING;
+		shelf_height = std::max(shelf_height, size.y);
+	}
+	unsigned height = y + shelf_height;
+
+	if (width > sf::Texture::getMaximumSize() ||
+		height > sf::Texture::getMaximumSize())
+	{
+		throw std::runtime_error("Texture atlas too large.");
+	}
+
+	// Copy every image into place & upload.
+	mImage.create(width, std::max(height, 1u), sf::Color::Transparent);
+	for (auto &i : images)
+	{
+		sf::IntRect rect = mRects[i.first];
+		mImage.copy(i.second, rect.left, rect.top);
+	}
+	mTexture.loadFromImage(mImage);
+}
+
+const sf::Texture &TextureAtlas::getTexture() const
+{
+	return mTexture;
+}
+
+sf::IntRect TextureAtlas::getRect(const std::string &path) const
+{
+	auto found = mRects.find(normalize(path));
+	if (found == mRects.end())
+	{
+		throw std::out_of_range("Image " + path + " is not in the atlas.");
+	}
+	return found->second;
+}
+
+sf::Sprite TextureAtlas::getSprite(const std::string &path) const
+{
+	return sf::Sprite(mTexture, getRect(path));
+}
+
+sf::Color TextureAtlas::getAverageColor(const sf::IntRect &rect) const
+{
+	unsigned r = 0, g = 0, b = 0, count = 0;
+	for (int y = rect.top; y < rect.top + rect.height; ++y)
+	{
+		for (int x = rect.left; x < rect.left + rect.width; ++x)
+		{
+			sf::Color pixel = mImage.getPixel(x, y);
+
+			// Skip transparent pixels.
+			if (pixel.a == 0)
+			{
+				continue;
+			}
+			r += pixel.r;
+			g += pixel.g;
+			b += pixel.b;
+			count++;
+		}
+	}
+
+	if (count == 0)
+	{
+		return sf::Color::Transparent;
+	}
+	return sf::Color(r / count, g / count, b / count);
+}
+
+std::string TextureAtlas::normalize(const std::string &path)
+{
+	return std::filesystem::path(path).lexically_normal().generic_string();
+}
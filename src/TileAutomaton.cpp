@@ -0,0 +1,418 @@
+#include "TileAutomaton.hpp"
+
+const uint8_t TileAutomaton::BORDER;
+
+TileAutomaton::TileAutomaton()
+{
+	mMap		= nullptr;
+	mChunkCount = {0, 0};
+	mStep		= 0;
+	mStepping	= false;
+	mStop		= false;
+	mGeneration = 0;
+	mNextChunk	= 0;
+	mRunning	= 0;
+}
+
+TileAutomaton::~TileAutomaton()
+{
+	// Leave no chunks for the workers to take, & wake them to stop.
+	mNextChunk = mChunkCount.x * mChunkCount.y;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStop = true;
+	}
+	mWake.notify_all();
+
+	for (auto &i : mWorkers)
+	{
+		i.join();
+	}
+}
+
+void TileAutomaton::init(Tilemap *map)
+{
+	mMap = map;
+
+	const nlohmann::json &data = mMap->getGrowthData();
+	if (data.is_null())
+	{
+		return;
+	}
+
+	if (mMap->getTileTypeCount() > BORDER)
+	{
+		throw std::runtime_error("Too many tile types to grow.");
+	}
+
+	float tps = data.at("tps").get<float>();
+	if (tps <= 0)
+	{
+		throw std::runtime_error("Growth tps must be positive.");
+	}
+	mInterval = sf::seconds(1.0f / tps);
+
+	// Resolve tile names, which come back as air if unknown.
+	std::string air_name = mMap->getTileDataFor(0).at("name").get<std::string>();
+	auto resolve = [&](const std::string &name) {
+		int id = mMap->getTileIDFromName(name);
+		if (id == 0 && name != air_name)
+		{
+			throw std::runtime_error("Growth rule -- unknown tile " + name);
+		}
+		return (uint8_t)id;
+	};
+
+	for (auto &i : data.at("rules"))
+	{
+		Rule rule;
+		rule.from = resolve(i.at("from").get<std::string>());
+		rule.to	  = resolve(i.at("to").get<std::string>());
+
+		rule.near		= BORDER;
+		rule.min		= 0;
+		rule.max		= 8;
+		rule.needs_near = false;
+
+		// Without a neighbour type, any neighbours will do.
+		auto near = i.find("near");
+		if (near != i.end())
+		{
+			rule.near = resolve(near->get<std::string>());
+			rule.min  = i.find("min") == i.end() ? 1 : i.at("min").get<int>();
+			rule.max  = i.find("max") == i.end() ? 8 : i.at("max").get<int>();
+			rule.needs_near = rule.min > 0;
+		}
+
+		double chance  = std::clamp(i.at("chance").get<double>(), 0.0, 1.0);
+		rule.threshold = (uint32_t)(chance * 4294967295.0);
+
+		mRules.push_back(rule);
+	}
+
+	// Copy the tiles into both grids, inside the border.
+	mSize		= mMap->getGridSize();
+	mChunkCount = {(mSize.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+				   (mSize.y + CHUNK_SIZE - 1) / CHUNK_SIZE};
+	mStride		= mSize.x + 2;
+	mFront.assign(mStride * (mSize.y + 2), BORDER);
+	for (int y = 0; y < mSize.y; ++y)
+	{
+		for (int x = 0; x < mSize.x; ++x)
+		{
+			mFront[padded(x, y)] = mMap->getTileIDAt(y * mSize.x + x);
+		}
+	}
+	mBack = mFront;
+
+	// Every chunk is stepped once, to find which ones can change.
+	mActive.assign(mChunkCount.x * mChunkCount.y, 1);
+	mChunkChanged.assign(mActive.size(), 0);
+
+	// Follow edits made by anything else.
+	mMap->addChangeListener([this](const Tilemap::TileChange &change) {
+		for (unsigned i : change.tiles)
+		{
+			uint8_t id = mMap->getTileIDAt(i);
+
+			// Hold edits back until the step is done.
+			if (mStepping)
+			{
+				mPending.push_back({i, id});
+			}
+			// Otherwise, skip our own step's changes.
+			else if (id != mFront[padded(i % mSize.x, i / mSize.x)])
+			{
+				setTile(i, id);
+			}
+		}
+	});
+
+	// Start a worker per core, idle until the first step.
+	unsigned count = std::max(1u, std::thread::hardware_concurrency());
+	mChanged.resize(count);
+	for (unsigned i = 0; i < count; ++i)
+	{
+		mWorkers.emplace_back(&TileAutomaton::work, this, std::ref(mChanged[i]));
+	}
+
+	mClock.restart();
+}
+
+bool TileAutomaton::update()
+{
+	if (mRules.empty())
+	{
+		return false;
+	}
+
+	// Wait on a running step.
+	bool changed = false;
+	if (mStepping)
+	{
+		if (mRunning != 0)
+		{
+			return false;
+		}
+		changed = finishStep();
+	}
+
+	if (mClock.getElapsedTime() >= mInterval)
+	{
+		mClock.restart();
+		startStep();
+	}
+	return changed;
+}
+
+sf::Time TileAutomaton::getTimeUntilStep() const
+{
+	// Without rules, nothing is ever due.
+	if (mRules.empty())
+	{
+		return sf::microseconds(std::numeric_limits<sf::Int64>::max());
+	}
+
+	// Check back soon on a running step, it's applied once finished.
+	sf::Time left = mInterval - mClock.getElapsedTime();
+	if (mStepping)
+	{
+		return std::min(left, STEP_POLL_TIME);
+	}
+	return left;
+}
+
+void TileAutomaton::startStep()
+{
+	for (auto &i : mChanged)
+	{
+		i.clear();
+	}
+	mNextChunk = 0;
+	mRunning   = mWorkers.size();
+	mStepping  = true;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mGeneration++;
+	}
+	mWake.notify_all();
+}
+
+bool TileAutomaton::finishStep()
+{
+	mStepping = false;
+	mFront.swap(mBack);
+	mStep++;
+
+	// Edits made during the step win over its results. Sorting keeps the
+	// edits of each tile in order, so the latest is applied last.
+	auto by_tile = [](const std::pair<unsigned, uint8_t> &a,
+					  const std::pair<unsigned, uint8_t> &b) {
+		return a.first < b.first;
+	};
+	std::stable_sort(mPending.begin(), mPending.end(), by_tile);
+	auto is_pending = [&](unsigned tile) {
+		return std::binary_search(mPending.begin(),
+								  mPending.end(),
+								  std::make_pair(tile, (uint8_t)0),
+								  by_tile);
+	};
+
+	// Hand every change to the map at once, & wake the chunks around them.
+	TileEditBatch batch;
+	for (auto &worker : mChanged)
+	{
+		for (unsigned tile : worker)
+		{
+			activateAround(tile);
+			if (!is_pending(tile))
+			{
+				batch.set(sf::Vector2i(tile % mSize.x, tile / mSize.x),
+						  mFront[padded(tile % mSize.x, tile / mSize.x)]);
+			}
+		}
+	}
+	mMap->applyEdits(batch);
+
+	// Then catch the grids up with the edits.
+	for (auto &i : mPending)
+	{
+		setTile(i.first, i.second);
+	}
+	mPending.clear();
+
+	return !batch.empty();
+}
+
+void TileAutomaton::setTile(unsigned tile, uint8_t id)
+{
+	int x = tile % mSize.x;
+	int y = tile / mSize.x;
+
+	mFront[padded(x, y)] = id;
+	mBack[padded(x, y)]	 = id;
+
+	// Rules around the tile may be able to fire now.
+	activateAround(tile);
+}
+
+void TileAutomaton::activateAround(unsigned tile)
+{
+	int x = tile % mSize.x;
+	int y = tile / mSize.x;
+
+	int left   = std::max(x - 1, 0) / CHUNK_SIZE;
+	int top	   = std::max(y - 1, 0) / CHUNK_SIZE;
+	int right  = std::min(x + 1, mSize.x - 1) / CHUNK_SIZE;
+	int bottom = std::min(y + 1, mSize.y - 1) / CHUNK_SIZE;
+	for (int cy = top; cy <= bottom; ++cy)
+	{
+		for (int cx = left; cx <= right; ++cx)
+		{
+			mActive[cy * mChunkCount.x + cx] = 1;
+		}
+	}
+}
+
+void TileAutomaton::work(std::vector<unsigned> &changed)
+{
+	unsigned total = mChunkCount.x * mChunkCount.y;
+	unsigned seen  = 0;
+	while (true)
+	{
+		// Wait for the next step, or to be stopped.
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWake.wait(lock, [&] { return mStop || mGeneration != seen; });
+			if (mStop)
+			{
+				return;
+			}
+			seen = mGeneration;
+		}
+
+		for (unsigned chunk = mNextChunk++; chunk < total; chunk = mNextChunk++)
+		{
+			stepChunk(chunk, changed);
+		}
+		mRunning--;
+	}
+}
+
+void TileAutomaton::stepChunk(unsigned chunk, std::vector<unsigned> &changed)
+{
+	int left   = (chunk % mChunkCount.x) * CHUNK_SIZE;
+	int top	   = (chunk / mChunkCount.x) * CHUNK_SIZE;
+	int width  = std::min(left + CHUNK_SIZE, mSize.x) - left;
+	int bottom = std::min(top + CHUNK_SIZE, mSize.y);
+
+	// Nothing here can change, so only catch the back grid up if it's behind.
+	if (!mActive[chunk])
+	{
+		if (mChunkChanged[chunk])
+		{
+			for (int y = top; y < bottom; ++y)
+			{
+				std::copy_n(&mFront[padded(left, y)], width, &mBack[padded(left, y)]);
+			}
+		}
+		mChunkChanged[chunk] = 0;
+		return;
+	}
+
+	bool chunk_changed = false;
+	for (int y = top; y < bottom; ++y)
+	{
+		const uint8_t *mid = &mFront[padded(left, y)];
+		uint8_t *out	   = &mBack[padded(left, y)];
+
+		// Start from the current row, & let the first rule to fire win.
+		std::copy_n(mid, width, out);
+		for (unsigned r = 0; r < mRules.size(); ++r)
+		{
+			uint32_t seed = mix(y * 0x85EBCA6Bu ^ mStep * 0xC2B2AE35u ^ r * 0x27D4EB2Fu);
+			applyRule(mRules[r], mid - mStride, mid, mid + mStride, out, width, seed, left);
+		}
+
+		// Note the changes.
+		if (!std::equal(mid, mid + width, out))
+		{
+			chunk_changed = true;
+			for (int x = 0; x < width; ++x)
+			{
+				if (out[x] != mid[x])
+				{
+					changed.push_back(y * mSize.x + left + x);
+				}
+			}
+		}
+	}
+
+	mActive[chunk]		 = isActive(left, top, width, bottom);
+	mChunkChanged[chunk] = chunk_changed;
+}
+
+bool TileAutomaton::isActive(int left, int top, int width, int bottom) const
+{
+	// Note which tile types are in the chunk.
+	std::array<uint8_t, 256> inside = {};
+	for (int y = top; y < bottom; ++y)
+	{
+		const uint8_t *row = &mBack[padded(left, y)];
+		for (int x = 0; x < width; ++x)
+		{
+			inside[row[x]] = 1;
+		}
+	}
+
+	// & in the ring around it, from mFront, as the neighbouring chunks may
+	// be writing theirs to mBack.
+	std::array<uint8_t, 256> around = {};
+	for (int x = -1; x <= width; ++x)
+	{
+		around[mFront[padded(left + x, top - 1)]] = 1;
+		around[mFront[padded(left + x, bottom)]]  = 1;
+	}
+	for (int y = top; y < bottom; ++y)
+	{
+		around[mFront[padded(left - 1, y)]]		= 1;
+		around[mFront[padded(left + width, y)]] = 1;
+	}
+
+	for (auto &rule : mRules)
+	{
+		if (inside[rule.from] &&
+			(!rule.needs_near || inside[rule.near] || around[rule.near]))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void TileAutomaton::applyRule(const Rule &rule,
+							  const uint8_t *up,
+							  const uint8_t *mid,
+							  const uint8_t *down,
+							  uint8_t *out,
+							  int width,
+							  uint32_t seed,
+							  int left) const
+{
+	const uint8_t n = rule.near;
+	for (int x = 0; x < width; ++x)
+	{
+		// Count the neighbours. Without a neighbour type this counts the
+		// border, but any count is then in range.
+		int near = (up[x - 1] == n) + (up[x] == n) + (up[x + 1] == n) +
+				   (mid[x - 1] == n) + (mid[x + 1] == n) +
+				   (down[x - 1] == n) + (down[x] == n) + (down[x + 1] == n);
+
+		uint32_t roll = mix(seed + (uint32_t)(left + x) * 0x9E3779B1u);
+		bool fire	  = (mid[x] == rule.from) & (out[x] == mid[x]) &
+					(near >= rule.min) & (near <= rule.max) &
+					(roll < rule.threshold);
+		out[x] = fire ? rule.to : out[x];
+	}
+}
@@ -0,0 +1,36 @@
+#include "TileEditBatch.hpp"
+
+TileEditBatch::TileEditBatch()
+{
+}
+
+void TileEditBatch::set(sf::Vector2i pos, int id)
+{
+	mEdits.push_back({.pos = pos, .id = id});
+}
+
+void TileEditBatch::fill(sf::IntRect rect, int id)
+{
+	for (int y = rect.top; y < rect.top + rect.height; ++y)
+	{
+		for (int x = rect.left; x < rect.left + rect.width; ++x)
+		{
+			set(sf::Vector2i(x, y), id);
+		}
+	}
+}
+
+const std::vector<TileEditBatch::Edit> &TileEditBatch::getEdits() const
+{
+	return mEdits;
+}
+
+bool TileEditBatch::empty() const
+{
+	return mEdits.empty();
+}
+
+void TileEditBatch::clear()
+{
+	mEdits.clear();
+}
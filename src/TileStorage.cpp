@@ -0,0 +1,186 @@
+#include "TileStorage.hpp"
+
+namespace
+{
+	/// Tiles per chunk.
+	const unsigned CHUNK_TILES = GridLayout::CHUNK_TILES;
+
+	/// The index widths chunks are promoted through.
+	const unsigned WIDTHS[] = {1, 2, 4, 8, 16};
+
+	/// The narrowest width that can index a palette of the given size.
+	unsigned widthFor(unsigned palette_size)
+	{
+		for (unsigned bits : WIDTHS)
+		{
+			if ((1u << bits) >= palette_size)
+			{
+				return bits;
+			}
+		}
+		throw std::length_error("Chunk palette exceeds 16 bits.");
+	}
+}
+
+TileStorage::TileStorage()
+{
+}
+
+void TileStorage::resize(sf::Vector2i size, int fill)
+{
+	mLayout = GridLayout(size);
+
+	// Every chunk starts as a single palette entry, at the narrowest width.
+	Chunk uniform;
+	uniform.palette = {fill};
+	uniform.refs	= {(uint16_t)CHUNK_TILES};
+	uniform.bits	= WIDTHS[0];
+	uniform.data.assign(CHUNK_TILES * uniform.bits / 64, 0);
+
+	mChunks.assign(mLayout.getStorageSize() / CHUNK_TILES, uniform);
+}
+
+void TileStorage::assign(sf::Vector2i size, const std::vector<int> &tiles)
+{
+	if (tiles.size() != (std::size_t)size.x * size.y)
+	{
+		throw std::invalid_argument("Tile array doesn't match the grid size.");
+	}
+
+	resize(size, tiles.empty() ? 0 : tiles[0]);
+	for (unsigned i = 0; i < tiles.size(); ++i)
+	{
+		set(i, tiles[i]);
+	}
+}
+
+int TileStorage::get(int x, int y) const
+{
+	auto loc = locate(x, y);
+	return get(loc.first, loc.second);
+}
+
+int TileStorage::get(unsigned index) const
+{
+	sf::Vector2i size = mLayout.getSize();
+	return get((int)(index % size.x), (int)(index / size.x));
+}
+
+void TileStorage::set(int x, int y, int id)
+{
+	auto loc	 = locate(x, y);
+	Chunk &chunk = mChunks[loc.first];
+
+	unsigned old = readIndex(chunk, loc.second);
+	if (chunk.palette[old] == id)
+	{
+		return;
+	}
+
+	// Release the old entry first, so its slot can be reused.
+	chunk.refs[old]--;
+	unsigned index = findOrAdd(chunk, id);
+	chunk.refs[index]++;
+	writeIndex(chunk, loc.second, index);
+}
+
+void TileStorage::set(unsigned index, int id)
+{
+	sf::Vector2i size = mLayout.getSize();
+	set((int)(index % size.x), (int)(index / size.x), id);
+}
+
+sf::Vector2i TileStorage::getSize() const
+{
+	return mLayout.getSize();
+}
+
+unsigned TileStorage::size() const
+{
+	sf::Vector2i size = mLayout.getSize();
+	return size.x * size.y;
+}
+
+const GridLayout &TileStorage::getLayout() const
+{
+	return mLayout;
+}
+
+std::size_t TileStorage::getMemoryUsage() const
+{
+	std::size_t total = mChunks.capacity() * sizeof(Chunk);
+	for (auto &chunk : mChunks)
+	{
+		total += chunk.palette.capacity() * sizeof(int) +
+				 chunk.refs.capacity() * sizeof(uint16_t) +
+				 chunk.data.capacity() * sizeof(uint64_t);
+	}
+	return total;
+}
+
+unsigned TileStorage::readIndex(const Chunk &chunk, unsigned tile)
+{
+	unsigned per_word = 64 / chunk.bits;
+	unsigned shift	  = (tile % per_word) * chunk.bits;
+	uint64_t mask	  = (uint64_t(1) << chunk.bits) - 1;
+	return (chunk.data[tile / per_word] >> shift) & mask;
+}
+
+void TileStorage::writeIndex(Chunk &chunk, unsigned tile, unsigned index)
+{
+	unsigned per_word = 64 / chunk.bits;
+	unsigned shift	  = (tile % per_word) * chunk.bits;
+	uint64_t mask	  = ((uint64_t(1) << chunk.bits) - 1) << shift;
+
+	uint64_t &word = chunk.data[tile / per_word];
+	word		   = (word & ~mask) | ((uint64_t)index << shift);
+}
+
+void TileStorage::repack(Chunk &chunk, unsigned bits)
+{
+	Chunk wide;
+	wide.bits = bits;
+	wide.data.assign(CHUNK_TILES * bits / 64, 0);
+	for (unsigned i = 0; i < CHUNK_TILES; ++i)
+	{
+		writeIndex(wide, i, readIndex(chunk, i));
+	}
+
+	chunk.bits = bits;
+	chunk.data.swap(wide.data);
+}
+
+unsigned TileStorage::findOrAdd(Chunk &chunk, int id)
+{
+	// Already in the palette.
+	auto found = std::find(chunk.palette.begin(), chunk.palette.end(), id);
+	if (found != chunk.palette.end())
+	{
+		return std::distance(chunk.palette.begin(), found);
+	}
+
+	// Reuse an entry no tile refers to anymore.
+	auto unused = std::find(chunk.refs.begin(), chunk.refs.end(), 0);
+	if (unused != chunk.refs.end())
+	{
+		unsigned index		 = std::distance(chunk.refs.begin(), unused);
+		chunk.palette[index] = id;
+		return index;
+	}
+
+	// Append, promoting the chunk if the new entry doesn't fit.
+	chunk.palette.push_back(id);
+	chunk.refs.push_back(0);
+	unsigned bits = widthFor(chunk.palette.size());
+	if (bits != chunk.bits)
+	{
+		repack(chunk, bits);
+	}
+	return chunk.palette.size() - 1;
+}
+
+std::pair<unsigned, unsigned> TileStorage::locate(int x, int y) const
+{
+	unsigned index = mLayout.index(sf::Vector2i(x, y));
+	return {index / CHUNK_TILES, index % CHUNK_TILES};
+}
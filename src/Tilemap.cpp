@@ -1,25 +1,128 @@
 #include "Tilemap.hpp"
 
-Tilemap::Tilemap()
+Tilemap::Tilemap(const TextureAtlas *atlas)
 {
-	// Set the vertices primitive type.
-	mVertices.setPrimitiveType(sf::Quads);
+	mAtlas = atlas;
 }
 
-Tilemap::Tilemap(std::string fname)
+Tilemap::Tilemap(std::string fname, const TextureAtlas *atlas)
 {
-	//Set the vertex primitive type.
-	mVertices.setPrimitiveType(sf::Quads);
+	mAtlas = atlas;
 
 	//Init the map.
-	loadFromFilename(fname);
+	if (!loadFromFilename(fname))
+	{
+		throw std::runtime_error("Could not load map " + fname);
+	}
 }
 
 void Tilemap::draw(sf::RenderTarget &target, sf::RenderStates states) const
 {
+	// Get the visible area, in the map's own coordinates.
+	const sf::View &view  = target.getView();
+	sf::FloatRect visible = getInverseTransform().transformRect(
+		sf::FloatRect(view.getCenter() - view.getSize() / 2.0f, view.getSize()));
+
+	// Get the range of chunks it covers.
+	sf::Vector2i chunks		= mTiles.getLayout().getChunkCount();
+	sf::Vector2f chunk_size = (sf::Vector2f)mTileDimensions * (float)GridLayout::CHUNK_SIZE;
+	int left   = std::max(0, (int)std::floor(visible.left / chunk_size.x));
+	int top	   = std::max(0, (int)std::floor(visible.top / chunk_size.y));
+	int right  = std::min(chunks.x, (int)std::ceil((visible.left + visible.width) / chunk_size.x));
+	int bottom = std::min(chunks.y, (int)std::ceil((visible.top + visible.height) / chunk_size.y));
+
+	// Set aside the layers of chunks that left the view.
+	auto out_of_view = [&](unsigned chunk) {
+		int x = chunk % chunks.x;
+		int y = chunk / chunks.x;
+		if (x >= left && x < right && y >= top && y < bottom)
+		{
+			return false;
+		}
+		mSpareLayers.push_back(std::move(mLayers[chunk]));
+		mChunkDirty[chunk] = true;
+		return true;
+	};
+	mLayerChunks.erase(std::remove_if(mLayerChunks.begin(), mLayerChunks.end(), out_of_view),
+					   mLayerChunks.end());
+
+	// Draw a quad per visible chunk, rendering any that are new or edited.
 	states.transform *= getTransform();
-	states.texture = &mMapTexture;
-	target.draw(mVertices, states);
+	for (int y = top; y < bottom; ++y)
+	{
+		for (int x = left; x < right; ++x)
+		{
+			unsigned chunk = y * chunks.x + x;
+			if (mChunkDirty[chunk])
+			{
+				renderChunk(chunk);
+			}
+
+			sf::Sprite layer(mLayers[chunk]->getTexture());
+			layer.setPosition(x * chunk_size.x, y * chunk_size.y);
+			target.draw(layer, states);
+		}
+	}
+}
+
+void Tilemap::markDirty(unsigned index)
+{
+	int x = index % mGridDimensions.x;
+	int y = index / mGridDimensions.x;
+
+	mChunkDirty[(y / GridLayout::CHUNK_SIZE) * mTiles.getLayout().getChunkCount().x +
+				x / GridLayout::CHUNK_SIZE] = true;
+}
+
+void Tilemap::renderChunk(unsigned chunk) const
+{
+	int chunks_across = mTiles.getLayout().getChunkCount().x;
+	sf::IntRect rect((chunk % chunks_across) * GridLayout::CHUNK_SIZE,
+					 (chunk / chunks_across) * GridLayout::CHUNK_SIZE,
+					 GridLayout::CHUNK_SIZE,
+					 GridLayout::CHUNK_SIZE);
+
+	// Give the chunk a layer, reusing a spare one if there is one.
+	std::unique_ptr<sf::RenderTexture> &layer = mLayers[chunk];
+	if (!layer)
+	{
+		if (!mSpareLayers.empty())
+		{
+			layer = std::move(mSpareLayers.back());
+			mSpareLayers.pop_back();
+		}
+		else
+		{
+			layer.reset(new sf::RenderTexture());
+			if (!layer->create(rect.width * mTileDimensions.x,
+							   rect.height * mTileDimensions.y))
+			{
+				throw std::runtime_error("Could not create a map layer.");
+			}
+		}
+		mLayerChunks.push_back(chunk);
+	}
+
+	// Gather the quads of its tiles, leaving out air.
+	mChunkQuads.setPrimitiveType(sf::Quads);
+	mChunkQuads.clear();
+	mTiles.forRect(rect, [&](sf::Vector2i pos, int id) {
+		if (id != 0)
+		{
+			appendTileQuad(mChunkQuads, pos, id);
+		}
+	});
+
+	// Render them from the chunk's top left.
+	sf::RenderStates states;
+	states.texture = &mAtlas->getTexture();
+	states.transform.translate(-rect.left * mTileDimensions.x,
+							   -rect.top * mTileDimensions.y);
+	layer->clear(sf::Color::Transparent);
+	layer->draw(mChunkQuads, states);
+	layer->display();
+
+	mChunkDirty[chunk] = false;
 }
 
 bool Tilemap::loadFromFilename(std::string fname)
@@ -60,9 +163,16 @@ bool Tilemap::loadFromFilename(std::string fname)
 	{
 		return false;
 	}
+	if (!initResources())
+	{
+		return false;
+	}
 
-	// Init the vertices, & return the final success code.
-	return updateVertices();
+	// Build the chunks once they're in view.
+	resetChunks();
+
+	// Return Successful.
+	return true;
 }
 
 bool Tilemap::getGraphicalData(nlohmann::json &graphicaldata)
@@ -85,11 +195,12 @@ Data to retrieve:
 	int tile_height = graphicaldata["tileheight"].get<int>();
 	mTileDimensions = sf::Vector2i(tile_width, tile_height);
 
-	// Retrieve the tile array.
-	mTiles = graphicaldata["layers"][0]["data"].get<std::vector<int>>();
+	// Retrieve the tile array, & compress it.
+	mTiles.assign(mGridDimensions,
+				  graphicaldata["layers"][0]["data"].get<std::vector<int>>());
 
-	// Load the texture.
-	mMapTexture.loadFromFile(
+	// Find the tileset in the atlas.
+	mTilesetRect = mAtlas->getRect(
 		"resource/maps/" +
 		graphicaldata["tilesets"][0]["image"].get<std::string>());
 
@@ -109,6 +220,12 @@ Data to retrieve:
 	// Get default tile data.//
 	mTileDefaults = tiledata["defaults"];
 
+	// Get the growth rules, if any.
+	if (tiledata.find("growth") != tiledata.end())
+	{
+		mGrowthData = tiledata["growth"];
+	}
+
 	///////////////////////////
 
 	// If there's no individual tile data, return successful.
@@ -124,86 +241,199 @@ Data to retrieve:
 	return true;
 }
 
-void Tilemap::setTileAt(sf::Vector2f pos, int newTileID)
+bool Tilemap::initResources()
 {
-	// Get the tile at the given position.
-	auto found = mTilePositions.find(getTileInside(pos));
+	mResources.assign(getTileTypeCount(), {.amount = 0, .becomes = 0});
+	for (int id = 0; id < (int)mResources.size(); ++id)
+	{
+		nlohmann::json data = getTileDataFor(id);
 
-	// If not found, return.
-	if (found == mTilePositions.end())
+		auto amount = data.find("amount");
+		if (amount == data.end())
+		{
+			continue;
+		}
+		mResources[id].amount = amount->get<unsigned>();
+
+		// Emptied tiles turn to air if not told otherwise.
+		auto becomes = data.find("becomes");
+		if (becomes != data.end())
+		{
+			std::string name	   = becomes->get<std::string>();
+			mResources[id].becomes = getTileIDFromName(name);
+
+			// Unknown names come back as air.
+			if (mResources[id].becomes == 0 &&
+				name != getTileDataFor(0).at("name").get<std::string>())
+			{
+				return false;
+			}
+		}
+	}
+
+	// Fill every tile with its type's resource.
+	std::vector<int> amounts(mGridDimensions.x * mGridDimensions.y);
+	for (unsigned i = 0; i < amounts.size(); ++i)
 	{
-		return;
+		amounts[i] = getStartingAmount(mTiles.get(i));
 	}
+	mAmounts.assign(mGridDimensions, amounts);
+
+	return true;
+}
 
-	// Otherwise, set the tile ID at that position.
-	if (newTileID != 0)
-		found->second = newTileID - 1;
+unsigned Tilemap::getStartingAmount(int tileID)
+{
+	if (tileID < 0 || tileID >= (int)mResources.size())
+	{
+		return 0;
+	}
+	return mResources[tileID].amount;
+}
 
-	// Get the position of it in the mTiles vector.
-	int vecpos = found->first.x + found->first.y * mGridDimensions.x;
+unsigned Tilemap::getAmountAt(unsigned tile)
+{
+	return mAmounts.get(tile);
+}
 
-	// Set the mTiles ID.
-	mTiles[vecpos] = newTileID;
+unsigned Tilemap::extract(unsigned tile, unsigned amount, TileEditBatch &conversions)
+{
+	unsigned left  = mAmounts.get(tile);
+	unsigned taken = std::min(left, amount);
+	if (taken == 0)
+	{
+		return 0;
+	}
+	mAmounts.set(tile, left - taken);
 
-	// Update the vertices.
-	updateVertices();
+	// Convert the tile once it's empty.
+	if (taken == left)
+	{
+		conversions.set(sf::Vector2i(tile % mGridDimensions.x,
+									 tile / mGridDimensions.x),
+						mResources[mTiles.get(tile)].becomes);
+	}
+	return taken;
 }
 
-bool Tilemap::updateVertices()
+const nlohmann::json &Tilemap::getGrowthData()
 {
-	// Clear any previous vertices.
-	mVertices.clear();
+	return mGrowthData;
+}
 
-	// Get the texture boundaries.
-	sf::Vector2i texSize = (sf::Vector2i)mMapTexture.getSize();
+void Tilemap::setTileAt(sf::Vector2f pos, int newTileID)
+{
+	// Get the tile at the given position.
+	int vecpos = getTileIndex(pos);
 
-	// Get the texture grid size.
-	sf::Vector2i texGridSize = {texSize.x / mTileDimensions.x,
-								texSize.y / mTileDimensions.y};
+	// If off the map, return.
+	if (vecpos == -1)
+	{
+		return;
+	}
 
-	// Iterate through all tiles.
-	for (unsigned i = 0; i < mTiles.size(); ++i)
+	TileEditBatch batch;
+	batch.set(sf::Vector2i(vecpos % mGridDimensions.x,
+						   vecpos / mGridDimensions.x),
+			  newTileID);
+	applyEdits(batch);
+}
+
+void Tilemap::applyEdits(const TileEditBatch &batch)
+{
+	TileChange change;
+
+	for (auto &edit : batch.getEdits())
 	{
-		// Ignore 0 (air) tiles.
-		if (mTiles[i] == 0)
+		// Skip off-map edits.
+		if (!mTiles.getLayout().contains(edit.pos))
 		{
 			continue;
 		}
 
-		// Decrement, because 0 is now not air, but the first non-air tile.
-		int tile = mTiles[i] - 1;
-
-		// Get the top_left position in the texture of the
-		// needed tile.
-		sf::Vector2f tex_pos = {
-			(float)(mTileDimensions.x * (tile % texGridSize.x)),
-			(float)(mTileDimensions.y * (tile / texGridSize.x))};
+		unsigned index = edit.pos.y * mGridDimensions.x + edit.pos.x;
+		if (mTiles.get(index) == edit.id)
+		{
+			continue;
+		}
 
-		// Get the top left position of the tile.
-		sf::Vector2f tile_pos = {
-			(float)mTileDimensions.x * (i % mGridDimensions.x),
-			(float)mTileDimensions.y * (i / mGridDimensions.x)};
+		// Update the tile, & render its chunk again next draw.
+		mTiles.set(index, edit.id);
+		mAmounts.set(index, getStartingAmount(edit.id));
+		markDirty(index);
 
-		sf::Vector2f width  = {(float)mTileDimensions.x, 0};
-		sf::Vector2f height = {0, (float)mTileDimensions.y};
+		// Grow the changed region to contain the tile.
+		if (change.tiles.empty())
+		{
+			change.region = sf::IntRect(edit.pos.x, edit.pos.y, 1, 1);
+		}
+		else
+		{
+			int right  = std::max(change.region.left + change.region.width, edit.pos.x + 1);
+			int bottom = std::max(change.region.top + change.region.height, edit.pos.y + 1);
+			change.region.left	 = std::min(change.region.left, edit.pos.x);
+			change.region.top	 = std::min(change.region.top, edit.pos.y);
+			change.region.width	 = right - change.region.left;
+			change.region.height = bottom - change.region.top;
+		}
+		change.tiles.push_back(index);
+	}
 
-		// Append the vertices.
-		sf::Vertex vertices[4] = {
-			sf::Vertex(tile_pos, tex_pos),
-			sf::Vertex(tile_pos + width, tex_pos + width),
-			sf::Vertex(tile_pos + width + height, tex_pos + width + height),
-			sf::Vertex(tile_pos + height, tex_pos + height)};
+	if (change.tiles.empty())
+	{
+		return;
+	}
 
-		// Append the quad to mTilePositions.
-		mTilePositions[tile_pos] = tile + 1;
+	// Report each tile once, even if it was edited repeatedly.
+	std::sort(change.tiles.begin(), change.tiles.end());
+	change.tiles.erase(std::unique(change.tiles.begin(), change.tiles.end()),
+					   change.tiles.end());
 
-		std::for_each(std::begin(vertices),
-					  std::end(vertices),
-					  [&](sf::Vertex &v) { mVertices.append(v); });
+	for (auto &listener : mChangeListeners)
+	{
+		listener(change);
 	}
+}
 
-	// Return Successful.
-	return true;
+void Tilemap::addChangeListener(ChangeListener listener)
+{
+	mChangeListeners.push_back(listener);
+}
+
+void Tilemap::resetChunks()
+{
+	sf::Vector2i chunks = mTiles.getLayout().getChunkCount();
+	mLayers.clear();
+	mLayers.resize(chunks.x * chunks.y);
+	mLayerChunks.clear();
+	mSpareLayers.clear();
+	mChunkDirty.assign(chunks.x * chunks.y, true);
+}
+
+void Tilemap::appendTileQuad(sf::VertexArray &vertices, sf::Vector2i pos, int id) const
+{
+	// Get the top left position of the tile.
+	sf::Vector2f tile_pos = {(float)mTileDimensions.x * pos.x,
+							 (float)mTileDimensions.y * pos.y};
+
+	sf::Vector2f width	= {(float)mTileDimensions.x, 0};
+	sf::Vector2f height = {0, (float)mTileDimensions.y};
+
+	// Get the texture grid size.
+	int texGridWidth = mTilesetRect.width / mTileDimensions.x;
+
+	// Decrement, because 0 is now not air, but the first non-air tile.
+	int tile = id - 1;
+
+	// Get the top_left position in the texture of the needed tile.
+	sf::Vector2f tex_pos = {
+		(float)(mTilesetRect.left + mTileDimensions.x * (tile % texGridWidth)),
+		(float)(mTilesetRect.top + mTileDimensions.y * (tile / texGridWidth))};
+
+	vertices.append(sf::Vertex(tile_pos, tex_pos));
+	vertices.append(sf::Vertex(tile_pos + width, tex_pos + width));
+	vertices.append(sf::Vertex(tile_pos + width + height, tex_pos + width + height));
+	vertices.append(sf::Vertex(tile_pos + height, tex_pos + height));
 }
 
 nlohmann::json Tilemap::getTileDataFor(int tileID)
@@ -257,9 +487,46 @@ sf::Vector2f Tilemap::getTileSize()
 	return (sf::Vector2f)mTileDimensions;
 }
 
-sf::Texture &Tilemap::getTileMapTexture()
+sf::Vector2i Tilemap::getGridSize()
 {
-	return mMapTexture;
+	return mGridDimensions;
+}
+
+std::vector<sf::Color> Tilemap::getTileColors()
+{
+	// Air is see-through.
+	std::vector<sf::Color> colors = {sf::Color::Transparent};
+
+	// Every other ID is a tile of the tileset, left->right.
+	sf::Vector2i tilesetGridSize = {mTilesetRect.width / mTileDimensions.x,
+									mTilesetRect.height / mTileDimensions.y};
+	for (int i = 0; i < tilesetGridSize.x * tilesetGridSize.y; ++i)
+	{
+		colors.push_back(mAtlas->getAverageColor(sf::IntRect(
+			mTilesetRect.left + (i % tilesetGridSize.x) * mTileDimensions.x,
+			mTilesetRect.top + (i / tilesetGridSize.x) * mTileDimensions.y,
+			mTileDimensions.x,
+			mTileDimensions.y)));
+	}
+
+	return colors;
+}
+
+void Tilemap::attachMinimap(Minimap *minimap)
+{
+	minimap->setGroundSource([this](unsigned tile) { return mTiles.get(tile); });
+
+	addChangeListener([minimap](const TileChange &change) {
+		for (unsigned i : change.tiles)
+		{
+			minimap->markChanged(i);
+		}
+	});
+}
+
+const sf::Texture &Tilemap::getTileMapTexture()
+{
+	return mAtlas->getTexture();
 }
 
 sf::FloatRect Tilemap::getTileTextureRect(std::string tile_name)
@@ -280,15 +547,15 @@ sf::FloatRect Tilemap::getTileTextureRect(std::string tile_name)
 
 	// Get the size of the tilemap texture itself.
 	sf::Vector2i tilemapGridSize = {
-		(int)mMapTexture.getSize().x / mTileDimensions.x,
-		(int)mMapTexture.getSize().y / mTileDimensions.y};
+		mTilesetRect.width / mTileDimensions.x,
+		mTilesetRect.height / mTileDimensions.y};
 
 	// Get the top left position.
 	sf::Vector2i top_left = {ID % tilemapGridSize.x, ID / tilemapGridSize.x};
 
 	// Set the new boundaries.
-	ret.left   = top_left.x * mTileDimensions.x;
-	ret.top	= top_left.y * mTileDimensions.y;
+	ret.left   = mTilesetRect.left + top_left.x * mTileDimensions.x;
+	ret.top	= mTilesetRect.top + top_left.y * mTileDimensions.y;
 	ret.width  = mTileDimensions.x;
 	ret.height = mTileDimensions.y;
 
@@ -298,6 +565,12 @@ sf::FloatRect Tilemap::getTileTextureRect(std::string tile_name)
 	return ret;
 }
 
+sf::Sprite Tilemap::getTileSprite(std::string tile_name)
+{
+	return sf::Sprite(mAtlas->getTexture(),
+					  (sf::IntRect)getTileTextureRect(tile_name));
+}
+
 int Tilemap::getTileIDFromName(std::string tile_name)
 {
 	// Iterate through all elements in mTileData.
@@ -321,16 +594,42 @@ int Tilemap::getTileIDFromName(std::string tile_name)
 
 int Tilemap::getTileID(sf::Vector2f pos)
 {
-	// Check if it's found.
-	auto found = mTilePositions.find(pos);
+	int index = getTileIndex(pos);
+
+	// Off the map.
+	if (index == -1)
+	{
+		return -1;
+	}
+
+	return mTiles.get((unsigned)index);
+}
+
+int Tilemap::getTileIDAt(unsigned tile)
+{
+	return mTiles.get(tile);
+}
+
+int Tilemap::getTileTypeCount()
+{
+	// Air, & every tile of the tileset.
+	return 1 + (mTilesetRect.width / mTileDimensions.x) *
+				   (mTilesetRect.height / mTileDimensions.y);
+}
+
+int Tilemap::getTileIndex(sf::Vector2f pos)
+{
+	if (pos.x < 0 || pos.y < 0)
+	{
+		return -1;
+	}
 
-	// If it's not found,
-	if (found == mTilePositions.end())
+	int x = pos.x / mTileDimensions.x;
+	int y = pos.y / mTileDimensions.y;
+	if (x >= mGridDimensions.x || y >= mGridDimensions.y)
 	{
-		// Return -1
 		return -1;
 	}
 
-	// Otherwise, return the ID.
-	return found->second;
+	return y * mGridDimensions.x + x;
 }
\ No newline at end of file
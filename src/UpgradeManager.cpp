@@ -7,7 +7,7 @@ UpgradeManager::UpgradeManager(BuildingManager* buildingmgr)
 	mRenderTooltip = false;
 	mBuilder	   = buildingmgr;
 
-	initUpgradeMap();
+	initMethodCompilers();
 }
 
 void UpgradeManager::loadUpgradeData(nlohmann::json object_data)
@@ -24,55 +24,170 @@ void UpgradeManager::loadUpgradeData(nlohmann::json object_data)
 		std::string upgrade_name = upgrade.at("name")
 									   .get<std::string>();
 
+		//Resolve the upgrade's prices & state.
+		UpgradeState state;
+		state.price		   = mMaterials->priceToCost(upgrade.at("price"));
+		state.unlock_price = mMaterials->priceToCost(upgrade.at("unlock_price"));
+		state.pricefactor  = upgrade.at("pricefactor").get<Fixed>();
+		state.uses		   = upgrade.at("uses").get<int>();
+		state.unlocked	   = upgrade.at("unlocked").get<bool>();
+		state.duration	   = upgrade.value("duration", 0ULL);
+		state.purchasable  = mMaterials->addPurchasable(state.price);
+
+		//Compile every method into effects.
+		for (auto& i : upgrade.at("methods"))
+		{
+			std::string method_name = i.at("call").get<std::string>();
+
+			auto compiler = mMethodCompilers.find(method_name);
+			if (compiler == mMethodCompilers.end())
+			{
+				throw std::runtime_error("Upgrade " + upgrade_name +
+										 " -- unknown method " + method_name);
+			}
+
+			compiler->second(i.at("args").get<nlohmann::json::array_t>(),
+							 state.effects);
+		}
+
+		mStates.push_back(state);
+
 		//Get the texture..
 		std::string texture_path = texture_prefix +
 								   upgrade.at("icon").get<std::string>();
 
-		//Load the texture.
-		mUpgradeTextures[upgrade_name].loadFromFile(texture_path);
+		//Find the texture in the atlas.
+		mIcons.push_back(mBuilder->getAtlas()->getSprite(texture_path));
+
+		//Format the tooltip.
+		UpgradeTooltip tooltip;
+		tooltip.icon = mIcons.back();
+		tooltip.name = upgrade_name;
+		for (auto& i : upgrade.at("description"))
+		{
+			tooltip.description.push_back(i.get<std::string>());
+		}
+		mTooltips.push_back(tooltip);
+		formatTooltipPrice(mTooltips.size() - 1);
 	}
+
+	//Settle pending changes, so the unlock index starts from current counts.
+	mMaterials->flushChanges();
+	initUnlocks();
+
+	//Track unlocks as resources change.
+	mMaterials->addChangeListener([this](MaterialManager::ResourceID id,
+										 const BigNumber& old_count,
+										 const BigNumber& new_count) {
+		onResourceChanged(id, old_count, new_count);
+	});
 }
 
-void UpgradeManager::renderGui()
+void UpgradeManager::initUnlocks()
 {
-	//To only hover one item per frame.
-	bool hoveredThisFrame = false;
-	mRenderTooltip		  = false;
+	mUnlockThresholds.assign(mMaterials->getResourceTypeCount(), {});
+	mUnlockMet.assign(mStates.size(), 0);
+	mUnlocked.clear();
 
-	//Render the buttons.
-	for (auto& i : mUpgrades)
+	for (unsigned i = 0; i < mStates.size(); ++i)
 	{
-		//Check if the upgrade is locked...
-		if (!i.at("unlocked").get<bool>())
+		UpgradeState& state = mStates[i];
+		if (state.unlocked)
 		{
-			//Unlock it if we can purchase it...
-			if (mMaterials->canPurchaseMultiple(
-					mMaterials->priceToResourceVector(i.at("unlock_price").get<nlohmann::json::array_t>())))
-			{
-				i["unlocked"] = true;
-			}
-			//Otherwise ignore this item.
-			else
+			mUnlocked.push_back(i);
+			continue;
+		}
+
+		//Index every threshold, counting the ones already met.
+		for (auto& r : state.unlock_price)
+		{
+			mUnlockThresholds[r.id].push_back({.count = r.count, .upgrade = i});
+			if (mMaterials->getResourceCount(r.id) >= r.count)
 			{
-				continue;
+				mUnlockMet[i]++;
 			}
 		}
 
-		//Assert the upgrade still has uses.
-		int uses = i.at("uses").get<int>();
-		if (uses == 0)
+		//An upgrade with everything met (or nothing to meet) starts unlocked.
+		if (mUnlockMet[i] == state.unlock_price.size())
 		{
-			continue;
+			state.unlocked = true;
+			mUnlocked.push_back(i);
 		}
+	}
+
+	for (auto& thresholds : mUnlockThresholds)
+	{
+		std::stable_sort(thresholds.begin(), thresholds.end(),
+						 [](const UnlockThreshold& a, const UnlockThreshold& b) {
+							 return a.count < b.count;
+						 });
+	}
+}
+
+void UpgradeManager::onResourceChanged(MaterialManager::ResourceID id,
+									   const BigNumber& old_count,
+									   const BigNumber& new_count)
+{
+	auto& thresholds = mUnlockThresholds[id];
+	auto above		 = [](const BigNumber& count, const UnlockThreshold& t) {
+		  return count < t.count;
+	};
+
+	//Thresholds are met when count >= threshold, so the ones crossed lie
+	//between the first threshold above each count.
+	auto from = std::upper_bound(thresholds.begin(), thresholds.end(), old_count, above);
+	auto to	  = std::upper_bound(thresholds.begin(), thresholds.end(), new_count, above);
 
-		//Get the texture.
-		auto* tex = getUpgradeTexture(i);
+	//Rising count, newly met thresholds.
+	for (auto i = from; i < to; ++i)
+	{
+		if (++mUnlockMet[i->upgrade] == mStates[i->upgrade].unlock_price.size())
+		{
+			unlock(i->upgrade);
+		}
+	}
 
-		//Get the vector of resources it costs.
-		std::vector<MaterialManager::Resource> resource_cost = mMaterials->priceToResourceVector(i.at("price").get<nlohmann::json::array_t>());
+	//Falling count, thresholds no longer met.
+	for (auto i = to; i < from; ++i)
+	{
+		mUnlockMet[i->upgrade]--;
+	}
+}
+
+void UpgradeManager::unlock(unsigned index)
+{
+	//Unlocks are permanent.
+	if (mStates[index].unlocked)
+	{
+		return;
+	}
+	mStates[index].unlocked = true;
+
+	//Keep the buttons in load order.
+	mUnlocked.insert(std::lower_bound(mUnlocked.begin(), mUnlocked.end(), index),
+					 index);
+}
+
+void UpgradeManager::renderGui()
+{
+	//To only hover one item per frame.
+	bool hoveredThisFrame = false;
+	mRenderTooltip		  = false;
+
+	//Render the buttons of unlocked upgrades.
+	for (unsigned i : mUnlocked)
+	{
+		UpgradeState& state = mStates[i];
+
+		//Assert the upgrade still has uses.
+		if (state.uses == 0)
+		{
+			continue;
+		}
 
 		//Check if we can purchase this item..
-		bool canPurchase	= mMaterials->canPurchaseMultiple(resource_cost);
+		bool canPurchase	= mMaterials->isAffordable(state.purchasable);
 		sf::Color tintColor = sf::Color::White;
 		sf::Color bgColor   = sf::Color::Transparent;
 
@@ -84,10 +199,12 @@ void UpgradeManager::renderGui()
 		}
 
 		//Draw the button.
-		if (ImGui::ImageButton(*tex, 1, bgColor, tintColor))
+		if (ImGui::ImageButton(mIcons[i], 1, bgColor, tintColor))
 		{
-			//If pressed, call the upgrade.
-			callUpgrade(i);
+			//If pressed, call the upgrade, as many times as possible if
+			//shift is held.
+			bool buyMax = KeyManager::getKeyState(sf::Keyboard::LShift) == 1;
+			callUpgrade(i, buyMax ? MAX_BULK_PURCHASES : 1);
 		}
 
 		//If the button is hovered...
@@ -96,7 +213,7 @@ void UpgradeManager::renderGui()
 			//Toggle tooltip rendering for that upgrade.
 			hoveredThisFrame = true;
 			mRenderTooltip   = true;
-			tooltipUpgrade   = &i;
+			tooltipUpgrade   = i;
 		}
 
 		ImGui::NextColumn();
@@ -114,94 +231,82 @@ bool UpgradeManager::renderGuiTooltip()
 	* Price...
 	*/
 
+	const UpgradeTooltip& tooltip = mTooltips[tooltipUpgrade];
+
 	//..Icon & name..
-	ImGui::Image(*getUpgradeTexture(*tooltipUpgrade));
+	ImGui::Image(tooltip.icon);
 	ImGui::SameLine();
-	ImGui::Text("%s", tooltipUpgrade->at("name").get<std::string>().c_str());
+	ImGui::Text("%s", tooltip.name.c_str());
 
 	//Description.
 	ImGui::Text(">");
 	ImGui::SameLine();
-	for (auto& i : tooltipUpgrade->at("description").get<nlohmann::json::array_t>())
+	for (auto& i : tooltip.description)
 	{
-		ImGui::Text("%s", i.get<std::string>().c_str());
+		ImGui::Text("%s", i.c_str());
 	};
 
 	//Price...
 	ImGui::Text("---\nPrice:");
-	for (auto& i : tooltipUpgrade->at("price"))
-	{
-		//Get the resource name & count.
-		std::string rname = i.at("name").get<std::string>();
-		int rcount		  = i.at("count").get<int>();
+	mBuilder->renderGuiLines(tooltip.price);
 
-		//Draw the image.
-		ImGui::Image(*mMaterials->getTexture(rname));
-		ImGui::SameLine();
-		//Resource name & count.
-		ImGui::Text("%s - %d",
-					rname.c_str(),
-					rcount);
-	}
+	ImGui::Text("---\nShift+Click to buy max.");
 
 	return true;
 }
 
-void UpgradeManager::callUpgrade(Upgrade& upgrade)
+unsigned UpgradeManager::callUpgrade(unsigned index, unsigned count)
 {
-	//Get the vector of resources it costs.
-	std::vector<MaterialManager::Resource> resource_cost = mMaterials->priceToResourceVector(upgrade.at("price").get<nlohmann::json::array_t>());
+	UpgradeState& state = mStates[index];
 
-	//Purchase it if we can..
-	if (!mMaterials->purchaseMultiple(resource_cost))
+	//Purchase one at a time, so each price increase is rounded exactly as
+	//it would be if bought separately.
+	unsigned purchased = 0;
+	while (purchased < count && state.uses != 0)
 	{
-		return;
-	}
+		//Stop once we can't afford it anymore.
+		if (!mMaterials->purchase(state.price))
+		{
+			break;
+		}
 
-	//..KK, now decrement it's uses.
-	int uses = upgrade["uses"].get<int>();
-	uses--;
-	upgrade["uses"] = uses;
+		//..KK, now decrement it's uses.
+		if (state.uses > 0)
+		{
+			state.uses--;
+		}
 
-	//Get the price factor.
-	float factor = upgrade.at("pricefactor").get<float>();
+		//Multiply all resources in the price by the price factor.
+		for (auto& i : state.price)
+		{
+			i.count = i.count * state.pricefactor;
+		}
 
-	//Multiply all resources in the price by the price factor.
-	for (auto& i : upgrade["price"])
-	{
-		float count = i.at("count").get<float>();
-		count *= factor;
-		i["count"] = count;
+		purchased++;
 	}
 
-	//Iterate over all methods.
-	for (auto& i : upgrade.at("methods"))
+	if (purchased != 0)
 	{
-		//Get the method.
-		std::string method_name				= i.at("call").get<std::string>();
-		nlohmann::json::array_t method_args = i.at("args")
-												  .get<nlohmann::json::array_t>();
-		//Call the method.
-		mUpgradeMap[method_name](method_args);
+		mMaterials->setPurchasableCost(state.purchasable, state.price);
+		formatTooltipPrice(index);
 	}
+
+	//Apply the effects once per purchase.
+	applyEffects(index, purchased);
+
+	return purchased;
 }
 
-sf::Texture* UpgradeManager::getUpgradeTexture(Upgrade& up)
+void UpgradeManager::formatTooltipPrice(unsigned index)
 {
-	//Get the name.
-	std::string name = up.at("name").get<std::string>();
+	auto& lines = mTooltips[index].price;
 
-	//Find the texture.
-	auto found = mUpgradeTextures.find(name);
-
-	//If it doesn't exist, return nullptr.
-	if (found == mUpgradeTextures.end())
-	{
-		return nullptr;
-	}
-	else
+	lines.clear();
+	for (auto& i : mStates[index].price)
 	{
-		//Otherwise, return the texture.
-		return &(found->second);
+		//Resource name & count.
+		lines.push_back({.icon = mMaterials->getIcon(i.id),
+						 .text = mMaterials->getResourceName(i.id) + " - " +
+								 i.count.format()});
 	}
-}
\ No newline at end of file
+}
@@ -1,52 +1,127 @@
 #include "UpgradeManager.hpp"
 
-void UpgradeManager::initUpgradeMap()
+void UpgradeManager::applyEffects(unsigned index, unsigned times)
 {
-	using array_t  = nlohmann::json::array_t;
-	using object_t = nlohmann::json::object_t;
-	using nlohmann::json;
+	const UpgradeState& state = mStates[index];
+
+	//Timed upgrades expire a set number of ticks from now.
+	unsigned long long expires = 0;
+	if (state.duration != 0)
+	{
+		expires = mBuilder->mTickCount + state.duration;
+		if (mBuilder->mNextExpiry == 0 || expires < mBuilder->mNextExpiry)
+		{
+			mBuilder->mNextExpiry = expires;
+		}
+	}
+
+	bool prices_changed = false;
+	for (auto& i : state.effects)
+	{
+		Modifier mod = {.type	 = i.type,
+						.value	 = i.value,
+						.source	 = index,
+						.count	 = times,
+						.expires = expires};
+
+		//TPS isn't per-building.
+		if (i.target == EffectTarget::TPS)
+		{
+			mBuilder->mTPS.push(mod);
+			continue;
+		}
+
+		//Find the cost list being modified.
+		BuildingManager::BuildingStats& stats = mBuilder->mStats[i.building];
+		mBuilder->invalidateTooltip(i.building);
+		switch (i.target)
+		{
+		case EffectTarget::PertickIn:
+			stats.resource_in.push(i.slot, mod);
+			break;
+		case EffectTarget::PertickOut:
+			stats.resource_out.push(i.slot, mod);
+			break;
+		case EffectTarget::Price:
+			stats.price.push(i.slot, mod);
+			prices_changed = true;
+			break;
+		case EffectTarget::SellPrice:
+		default:
+			stats.sellprice.push(i.slot, mod);
+			break;
+		}
+	}
+
+	if (prices_changed)
+	{
+		mBuilder->refreshPrices();
+	}
+}
+
+void UpgradeManager::initMethodCompilers()
+{
+	using array_t = nlohmann::json::array_t;
 	using std::string;
 
 	/**
 	 * @brief When executing upgrades that modify values, operators are usually passed by string. This function therefore reduces boilerplate code.
-	 * 
+	 *
 	 */
-	auto exec_oper =
-		[&](string oper, float& lvalue, const float& rvalue) {
-			//Iterate through the operator choices.
-			if (oper == "+")
-			{
-				lvalue += rvalue;
-			}
-			else if (oper == "-")
-			{
-				lvalue -= rvalue;
-			}
-			else if (oper == "*")
-			{
-				lvalue *= rvalue;
-			}
-			else if (oper == "/")
-			{
-				lvalue /= rvalue;
-			}
-			else if (oper == "=")
-			{
-				lvalue = rvalue;
-			}
-		};
+	auto parse_oper = [](string oper, Fixed value) -> std::pair<ModifierType, Fixed> {
+		//Iterate through the operator choices.
+		if (oper == "+")
+			return {ModifierType::Add, value};
+		if (oper == "-")
+			return {ModifierType::Add, Fixed() - value};
+		if (oper == "*")
+			return {ModifierType::Multiply, value};
+		if (oper == "/")
+		{
+			if (value == Fixed())
+				throw std::runtime_error("Upgrade divides by zero");
+			return {ModifierType::Divide, value};
+		}
+		if (oper == "=")
+			return {ModifierType::Override, value};
+
+		throw std::runtime_error("Unknown upgrade operator " + oper);
+	};
+
+	/**
+	 * @brief Finds the slot of a resource in a building's cost list.
+	 *
+	 */
+	auto find_slot = [&](const MaterialManager::Cost& cost, string rname) -> unsigned {
+		MaterialManager::ResourceID id = this->mMaterials->getResourceID(rname);
+
+		auto resource = std::find_if(cost.begin(), cost.end(), [&](const MaterialManager::ResourceAmount& r) {
+			return r.id == id;
+		});
+		if (resource == cost.end())
+		{
+			throw std::runtime_error("Upgrade targets resource " + rname +
+									 ", which the building doesn't use.");
+		}
+
+		return std::distance(cost.begin(), resource);
+	};
 
 	/**
 	 * @brief Increases the TPS by the first arg.
-	 * 
+	 *
 	 */
-	mUpgradeMap["tps_inc"] = [&](array_t args) {
-		this->mBuilder->mTPS += args.at(0).get<float>();
+	mMethodCompilers["tps_inc"] = [&](array_t args, std::vector<Effect>& out) {
+		out.push_back({.target	 = EffectTarget::TPS,
+					   .building = 0,
+					   .slot	 = 0,
+					   .type	 = ModifierType::Add,
+					   .value	 = args.at(0).get<Fixed>()});
 	};
 
 	/**
 	 * @brief Changes a building's pertick value.
-	 * 
+	 *
 	 * @param args {
 	 * 0: Building name.
 	 * 1: "out" or "in" (resource_out / resource_in)
@@ -54,38 +129,28 @@ void UpgradeManager::initUpgradeMap()
 	 * 3: The operator to act on the existing value
 	 * 4: The rvalue.
 	 * }
-	 * 
+	 *
 	 */
-	mUpgradeMap["pertick_mod"] = [&, exec_oper](array_t args) {
-		string bname		 = args.at(0).get<string>();
-		string resource_oper = "resource_" + args.at(1).get<string>();
-		string rname		 = args.at(2).get<string>();
-		string oper			 = args.at(3).get<string>();
-		float value			 = args.at(4).get<float>();
+	mMethodCompilers["pertick_mod"] = [&, parse_oper, find_slot](array_t args, std::vector<Effect>& out) {
+		string bname = args.at(0).get<string>();
+		bool is_in	 = args.at(1).get<string>() == "in";
+		string rname = args.at(2).get<string>();
+		auto oper	 = parse_oper(args.at(3).get<string>(), args.at(4).get<Fixed>());
 
 		//Get the resource array.
-		BuildingManager::Building* building = this->mBuilder->getBuilding(bname);
-		array_t resources					= (*building)["pertick"][resource_oper];
-
-		//Find the necessary value.
-		auto resource = std::find_if(resources.begin(), resources.end(), [&](json& obj) -> bool {
-			return obj.at("name").get<string>() == rname;
-		});
-		int index	 = std::distance(resources.begin(), resource);
-
-		//Get the resource count.
-		float ct = resource->at("count").get<float>();
-
-		//Execute the operator.
-		exec_oper(oper, ct, value);
-
-		//Set the new resource count.
-		(*building)["pertick"][resource_oper][index]["count"] = ct;
+		BuildingManager::BuildingID building = this->mBuilder->getBuildingID(bname);
+		BuildingManager::BuildingStats& stats = this->mBuilder->mStats[building];
+
+		out.push_back({.target	 = is_in ? EffectTarget::PertickIn : EffectTarget::PertickOut,
+					   .building = building,
+					   .slot	 = find_slot(is_in ? stats.resource_in.getBase() : stats.resource_out.getBase(), rname),
+					   .type	 = oper.first,
+					   .value	 = oper.second});
 	};
 
 	/**
 	 * @brief Modifies the price / sell price of the building.
-	 * 
+	 *
 	 * @param args {
 	 * 0: "sell", "buy", or "both" - which type of cost to modify.
 	 * 1: The building name.
@@ -93,65 +158,33 @@ void UpgradeManager::initUpgradeMap()
 	 * 3: The operator to act on the existing value.
 	 * 4: The rvalue.
 	 * }
-	 * 
+	 *
 	 */
-	mUpgradeMap["price_mod"] = [&, exec_oper](array_t args) {
+	mMethodCompilers["price_mod"] = [&, parse_oper, find_slot](array_t args, std::vector<Effect>& out) {
 		string cost_to_modify = args.at(0).get<string>();
 		string building_name  = args.at(1).get<string>();
 		string resource_name  = args.at(2).get<string>();
-		string oper			  = args.at(3).get<string>();
-		float rvalue		  = args.at(4).get<float>();
+		auto oper			  = parse_oper(args.at(3).get<string>(), args.at(4).get<Fixed>());
 
 		//Get the building.
-		auto building = this->mBuilder->getBuilding(building_name);
+		BuildingManager::BuildingID building = this->mBuilder->getBuildingID(building_name);
+		BuildingManager::BuildingStats& stats = this->mBuilder->mStats[building];
 
 		if (cost_to_modify == "buy" || cost_to_modify == "both")
 		{
-			//Get the price.
-			array_t cprice = building->at("price");
-
-			//Get the resource count to modify.
-			auto resource =
-				std::find_if(cprice.begin(),
-							 cprice.end(),
-							 [&](json& obj) -> bool {
-								 return obj["name"].get<string>() == resource_name;
-							 });
-
-			float resource_val = resource->at("count").get<float>();
-
-			//Fix the value.
-			exec_oper(oper, resource_val, rvalue);
-
-			//Get the distance into the price vector we are.
-			int index = std::distance(cprice.begin(), resource);
-
-			//Push the resource back.
-			(*building)["price"][index]["count"] = (long)resource_val;
+			out.push_back({.target	 = EffectTarget::Price,
+						   .building = building,
+						   .slot	 = find_slot(stats.price.getBase(), resource_name),
+						   .type	 = oper.first,
+						   .value	 = oper.second});
 		}
 		if (cost_to_modify == "sell" || cost_to_modify == "both")
 		{
-			//Get the price.
-			array_t cprice = building->at("sellprice");
-
-			//Get the resource count to modify.
-			auto resource =
-				std::find_if(cprice.begin(),
-							 cprice.end(),
-							 [&](json& obj) -> bool {
-								 return obj["name"].get<string>() == resource_name;
-							 });
-
-			float resource_val = resource->at("count").get<float>();
-
-			//Fix the value.
-			exec_oper(oper, resource_val, rvalue);
-
-			//Get the distance into the price vector we are.
-			int index = std::distance(cprice.begin(), resource);
-
-			//Push the resource back.
-			(*building)["sellprice"][index]["count"] = (long)resource_val;
+			out.push_back({.target	 = EffectTarget::SellPrice,
+						   .building = building,
+						   .slot	 = find_slot(stats.sellprice.getBase(), resource_name),
+						   .type	 = oper.first,
+						   .value	 = oper.second});
 		}
 	};
-}
\ No newline at end of file
+}